@@ -0,0 +1,42 @@
+/**
+ * @file arena.c
+ * @author Giancarlo Buenaflor <e51837398@tuwien.ac.at>
+ * @date 18.11.2020
+ *
+ * @brief Implementation of the arena module.
+ *
+ **/
+
+#include "arena.h"
+
+void initArena(arena *a, size_t size) {
+  a->size = getArenaBytes(size);
+  a->used = 0;
+  // Room to move base up to the next hugepage boundary
+  a->mapping_size = a->size + ARENA_ALIGNMENT;
+  a->mapping = mmap(NULL, a->mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (a->mapping == MAP_FAILED) {
+    printErrAndExit("Mapping worker arena failed");
+  }
+  a->base = (unsigned char *) (((uintptr_t) a->mapping + ARENA_ALIGNMENT - 1) & ~((uintptr_t) ARENA_ALIGNMENT - 1));
+#ifdef MADV_HUGEPAGE
+  madvise(a->base, a->size, MADV_HUGEPAGE);
+#endif
+  // The first touch decides the memory node of a page
+  memset(a->base, 0, a->size);
+}
+
+void freeArena(arena *a) {
+  munmap(a->mapping, a->mapping_size);
+  memset(a, 0, sizeof(arena));
+}
+
+void *arenaAlloc(arena *a, size_t size) {
+  size_t bytes = getArenaBytes(size);
+  if (bytes > a->size - a->used) {
+    printErrAndExit("Worker arena exhausted");
+  }
+  void *p = a->base + a->used;
+  a->used += bytes;
+  return memset(p, 0, bytes);
+}
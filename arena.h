@@ -0,0 +1,90 @@
+/**
+ * @file arena.h
+ * @author Giancarlo Buenaflor <e51837398@tuwien.ac.at>
+ * @date 18.11.2020
+ *
+ * @brief Provides the memory arena every worker carves its search state from.
+ *
+ * The arena module. A worker maps one arena when it starts, after it has been pinned, and touches every page right
+ * away: the kernel places the pages on the memory node of the worker's core (first touch) and, where transparent
+ * hugepages are enabled for madvise, backs them with hugepages. Allocations take the next cache-line aligned bytes and
+ * are released all at once by going back to a mark, so restarting or switching the search costs no call to malloc
+ * and the worker only touches its own node-local memory.
+ * The size of the arena is computed up front from the graph (see getSearchBytes), running out of it is a bug.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "sharedmem.h"
+
+/** Alignment of the arena mapping, the size of a transparent hugepage on x86-64 and most arm64 kernels */
+#define ARENA_ALIGNMENT (2 * 1024 * 1024)
+
+/** Represents a memory arena
+ * @brief base to base + size are the usable bytes, of which the first used are allocated. mapping and mapping_size
+ * describe the whole mapping, base is its first ARENA_ALIGNMENT boundary.
+ */
+typedef struct arena {
+  unsigned char *base;
+  size_t size;
+  size_t used;
+  void *mapping;
+  size_t mapping_size;
+} arena;
+
+/**
+ * Rounds an allocation up to what it takes in an arena
+ * @param size The number of bytes
+ * @return Returns size rounded up to a cache line (at least one line).
+*/
+static inline size_t getArenaBytes(size_t size) {
+  return size > 0 ? (size + CACHE_LINE - 1) & ~((size_t) CACHE_LINE - 1) : CACHE_LINE;
+}
+
+/**
+ * Maps an arena
+ * @brief Maps and touches size bytes, requesting hugepages where the kernel supports them
+ * @details Must be called by the thread that uses the arena, after it has been pinned. If mapping fails, the program
+ * prints an error and exits
+ * @param a The arena
+ * @param size The number of bytes, the sum of the getArenaBytes of all allocations that may be live at once
+*/
+void initArena(arena *a, size_t size);
+
+/**
+ * Unmaps an arena
+ * @param a The arena
+*/
+void freeArena(arena *a);
+
+/**
+ * Allocates from an arena
+ * @brief Takes the next getArenaBytes(size) bytes and clears them
+ * @details If the arena is exhausted, the program prints an error and exits
+ * @param a The arena
+ * @param size The number of bytes
+ * @return Returns the cache-line aligned memory.
+*/
+void *arenaAlloc(arena *a, size_t size);
+
+/**
+ * Marks an arena
+ * @param a The arena
+ * @return Returns the mark to go back to with resetArena.
+*/
+static inline size_t getArenaMark(const arena *a) {
+  return a->used;
+}
+
+/**
+ * Resets an arena
+ * @brief Releases everything allocated since the mark
+ * @param a The arena
+ * @param mark The mark returned by getArenaMark
+*/
+static inline void resetArena(arena *a, size_t mark) {
+  a->used = mark;
+}
+
+#endif
@@ -0,0 +1,501 @@
+/**
+ * @file bench.c
+ * @author Giancarlo Buenaflor <e51837398@tuwien.ac.at>
+ * @date 18.11.2020
+ *
+ * @brief Benchmark program module.
+ *
+ * This program "bench" measures the conflict kernels and the circular buffer. The kernel benchmarks count the
+ * conflicts of random colorings on synthetic graphs (Erdos-Renyi, power-law and grid, 1e3 edges up to -e edges in
+ * steps of 10) with every kernel the cpu supports, the bounded scans and the edge array functions of sharedmem.h.
+ * The buffer benchmark forks -p producers that write time-stamped cells the way generators do, while this process
+ * reads them the way the supervisor does, and measures the messages per second and the enqueue-to-dequeue latency.
+ * Every result is printed to stdout as one JSON object per line.
+ *
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <math.h>
+#include <sched.h>
+#include <getopt.h>
+#include <sys/wait.h>
+#include "sharedmem.h"
+#include "random.h"
+#include "graph.h"
+#include "kernel.h"
+
+/** Default largest benchmark graph, smallest graph and minimum time per measurement in nanoseconds */
+#define DEFAULT_MAX_EDGES (1000000)
+#define MIN_EDGES (1000)
+#define MIN_BENCH_NS (200000000UL)
+
+/** Number of colorings the kernel benchmarks cycle through */
+#define NUM_COLORINGS (8)
+
+/** Default buffer benchmark: producers, messages per producer and batch size */
+#define DEFAULT_PRODUCERS (4)
+#define DEFAULT_MESSAGES (100000)
+#define DEFAULT_BATCH (1)
+
+/** Represents the synthetic graph families */
+typedef enum graphFamily {
+  GRAPH_ER = 0,
+  GRAPH_POWERLAW,
+  GRAPH_GRID,
+  NUM_FAMILIES
+} graphFamily;
+
+/** The names of the graph families, indexed by graphFamily */
+static const char *family_names[NUM_FAMILIES] = {"er", "powerlaw", "grid"};
+
+/** Represents a benchmark graph
+ * @brief g is the graph as the generator prepares it, edges the same edges as an array (in the ids of g.store).
+ * colors and packed hold NUM_COLORINGS random colorings, removed is scratch space for bound edges.
+ */
+typedef struct benchGraph {
+  graph g;
+  edge *edges;
+  int *colors[NUM_COLORINGS];
+  uint64_t *packed[NUM_COLORINGS];
+  edge *removed;
+  int bound;
+} benchGraph;
+
+/** Represents a variant measured by the kernel benchmarks
+ * @brief run counts (or bounds) the conflicts of coloring i, kernel is used by the edge store variants
+ */
+typedef struct benchVariant {
+  char name[64];
+  int (*run)(const struct benchVariant *v, benchGraph *b, int i);
+  conflictKernel kernel;
+} benchVariant;
+
+/** Keeps the results alive, so the compiler can't drop the measured calls */
+static volatile int sink;
+
+/**
+ * Allocates memory or exits
+ * @param size The number of bytes
+ * @return Returns the allocated memory.
+*/
+static void *allocOrExit(size_t size) {
+  void *p = malloc(size > 0 ? size : 1);
+  if (p == NULL) {
+    printErrAndExit("Allocating benchmark memory failed");
+  }
+  return p;
+}
+
+/**
+ * Generates a synthetic graph
+ * @brief Erdos-Renyi draws uniform random pairs on numOfEdges / 8 vertices. Power-law attaches every new vertex to 8
+ * endpoints of random earlier edges (preferential attachment). Grid connects every vertex of a square grid to its
+ * right and lower neighbour.
+ * @param family The graph family
+ * @param numOfEdges The number of edges (about, for the grid)
+ * @param r The random number generator
+ * @param list The edge list that will be filled (zero initialized)
+*/
+static void generateGraph(graphFamily family, long numOfEdges, rng *r, edgeList *list) {
+  if (family == GRAPH_GRID) {
+    int side = (int) sqrt(numOfEdges / 2.0) + 1;
+    for (int y = 0; y < side; y++) {
+      for (int x = 0; x < side; x++) {
+        if (x + 1 < side) {
+          appendEdge(list, y * side + x, y * side + x + 1);
+        }
+        if (y + 1 < side) {
+          appendEdge(list, y * side + x, (y + 1) * side + x);
+        }
+      }
+    }
+    return;
+  }
+  int numOfVertices = numOfEdges / 8 > 16 ? numOfEdges / 8 : 16;
+  for (long e = 0; e < numOfEdges; e++) {
+    int source, destination;
+    if (family == GRAPH_ER) {
+      source = nextBounded(r, numOfVertices);
+      destination = nextBounded(r, numOfVertices - 1);
+      destination += destination >= source;
+    } else {
+      source = 1 + e / 8;
+      // Picking an endpoint of a random earlier edge picks a vertex proportional to its degree
+      if (e == 0) {
+        destination = 0;
+      } else {
+        edge earlier = list->edges[nextBounded(r, e)];
+        destination = nextBounded(r, 2) ? earlier.source : earlier.destination;
+      }
+      if (destination == source) {
+        destination = nextBounded(r, source);
+      }
+    }
+    appendEdge(list, source, destination);
+  }
+}
+
+/**
+ * Prepares a benchmark graph
+ * @param b The benchmark graph
+ * @param family The graph family
+ * @param numOfEdges The number of edges
+ * @param r The random number generator
+*/
+static void initBenchGraph(benchGraph *b, graphFamily family, long numOfEdges, rng *r) {
+  edgeList list = {0};
+  generateGraph(family, numOfEdges, r, &list);
+  buildGraph(&b->g, &list, DEFAULT_REORDER_EDGES, 0);
+  freeEdgeList(&list);
+
+  const edgeStore *store = &b->g.store;
+  b->edges = allocOrExit(store->numOfEdges * sizeof(edge));
+  for (int e = 0; e < store->numOfEdges; e++) {
+    b->edges[e].source = getEdgeSource(store, e);
+    b->edges[e].destination = getEdgeDestination(store, e);
+  }
+  for (int i = 0; i < NUM_COLORINGS; i++) {
+    b->colors[i] = allocOrExit(store->numOfVertices * sizeof(int));
+    b->packed[i] = allocOrExit(getPackedWords(store->numOfVertices) * sizeof(uint64_t));
+    randomizeColors(r, store->numOfVertices, b->colors[i]);
+    for (int w = 0; w < getPackedWords(store->numOfVertices); w++) {
+      b->packed[i][w] = 0;
+    }
+    for (int v = 0; v < store->numOfVertices; v++) {
+      b->packed[i][v / PACKED_COLORS_PER_WORD] |= (uint64_t) b->colors[i][v] << (2 * (v % PACKED_COLORS_PER_WORD));
+    }
+  }
+  // Like a search that is close to its best solution, about half of the conflicts of a random coloring are accepted
+  b->bound = countConflicts(b->colors[0], b->edges, store->numOfEdges, INT_MAX) / 2;
+  b->removed = allocOrExit((b->bound + 1) * sizeof(edge));
+}
+
+/**
+ * Frees a benchmark graph
+ * @param b The benchmark graph
+*/
+static void freeBenchGraph(benchGraph *b) {
+  freeGraph(&b->g);
+  free(b->edges);
+  for (int i = 0; i < NUM_COLORINGS; i++) {
+    free(b->colors[i]);
+    free(b->packed[i]);
+  }
+  free(b->removed);
+}
+
+/** Counts all conflicts with a kernel of the edge store */
+static int runKernel(const benchVariant *v, benchGraph *b, int i) {
+  int first;
+  return v->kernel(&b->g.store, b->colors[i], INT_MAX, &first);
+}
+
+/** Bounded scan of the edge store with a kernel, see solveEdgeStoreBounded */
+static int runKernelBounded(const benchVariant *v, benchGraph *b, int i) {
+  int count = 0;
+  return solveEdgeStoreBounded(v->kernel, &b->g.store, b->colors[i], b->bound, b->removed, &count) + count;
+}
+
+/** Counts all conflicts of the edge array, see countConflicts */
+static int runArray(const benchVariant *v, benchGraph *b, int i) {
+  return countConflicts(b->colors[i], b->edges, b->g.store.numOfEdges, INT_MAX);
+}
+
+/** Counts all conflicts of the edge array with a packed coloring, see countConflictsPacked */
+static int runArrayPacked(const benchVariant *v, benchGraph *b, int i) {
+  return countConflictsPacked(b->packed[i], b->edges, b->g.store.numOfEdges, INT_MAX);
+}
+
+/** Bounded scan of the edge array, see solveColorProblemBounded */
+static int runArrayBounded(const benchVariant *v, benchGraph *b, int i) {
+  int count = 0;
+  return solveColorProblemBounded(b->colors[i], b->edges, b->g.store.numOfEdges, b->bound, b->removed, &count) + count;
+}
+
+/**
+ * Measures a function
+ * @brief Runs it in rounds of doubling length until a round takes at least MIN_BENCH_NS
+ * @param v The variant
+ * @param b The benchmark graph
+ * @return Returns the calls per second of the last round.
+*/
+static double measureVariant(const benchVariant *v, benchGraph *b) {
+  for (long rounds = 1;; rounds *= 2) {
+    unsigned long start = getMonotonicNanos();
+    int acc = 0;
+    for (long k = 0; k < rounds; k++) {
+      acc += v->run(v, b, k % NUM_COLORINGS);
+    }
+    sink = acc;
+    unsigned long elapsed = getMonotonicNanos() - start;
+    if (elapsed >= MIN_BENCH_NS) {
+      return rounds * 1e9 / elapsed;
+    }
+  }
+}
+
+/**
+ * Runs the kernel benchmarks
+ * @brief Measures every variant on every graph family and size and prints one result per line
+ * @param max_edges The largest graph
+ * @param r The random number generator
+*/
+static void benchKernels(long max_edges, rng *r) {
+  for (long numOfEdges = MIN_EDGES; numOfEdges <= max_edges; numOfEdges *= 10) {
+    for (int family = 0; family < NUM_FAMILIES; family++) {
+      benchGraph b;
+      initBenchGraph(&b, family, numOfEdges, r);
+      const edgeStore *store = &b.g.store;
+
+      benchVariant variants[2 * MAX_CONFLICT_KERNELS + 3];
+      conflictKernel kernels[MAX_CONFLICT_KERNELS];
+      int num_kernels = listConflictKernels(store, kernels), num_variants = 0;
+      for (int k = 0; k < num_kernels; k++) {
+        variants[num_variants] = (benchVariant) {.run = runKernel, .kernel = kernels[k]};
+        snprintf(variants[num_variants++].name, sizeof(variants[0].name), "%s", getConflictKernelName(kernels[k]));
+        variants[num_variants] = (benchVariant) {.run = runKernelBounded, .kernel = kernels[k]};
+        snprintf(variants[num_variants++].name, sizeof(variants[0].name), "bounded-%s", getConflictKernelName(kernels[k]));
+      }
+      variants[num_variants++] = (benchVariant) {.name = "array", .run = runArray};
+      variants[num_variants++] = (benchVariant) {.name = "array-packed", .run = runArrayPacked};
+      variants[num_variants++] = (benchVariant) {.name = "array-bounded", .run = runArrayBounded};
+
+      for (int i = 0; i < num_variants; i++) {
+        double rate = measureVariant(&variants[i], &b);
+        printf("{\"bench\":\"kernel\",\"graph\":\"%s\",\"vertices\":%d,\"edges\":%d,\"variant\":\"%s\","
+          "\"colorings_per_sec\":%.1f,\"edges_per_sec\":%.0f}\n", family_names[family], store->numOfVertices,
+          store->numOfEdges, variants[i].name, rate, rate * store->numOfEdges);
+        fflush(stdout);
+      }
+
+      unsigned long start = getMonotonicNanos();
+      long rounds = 0;
+      while (getMonotonicNanos() - start < MIN_BENCH_NS) {
+        randomizeColors(r, store->numOfVertices, b.colors[rounds++ % NUM_COLORINGS]);
+      }
+      double rate = rounds * 1e9 / (getMonotonicNanos() - start);
+      printf("{\"bench\":\"randomize\",\"graph\":\"%s\",\"vertices\":%d,\"edges\":%d,"
+        "\"colorings_per_sec\":%.1f,\"vertices_per_sec\":%.0f}\n", family_names[family], store->numOfVertices,
+        store->numOfEdges, rate, rate * store->numOfVertices);
+      fflush(stdout);
+      freeBenchGraph(&b);
+    }
+  }
+}
+
+/**
+ * Producer of the buffer benchmark
+ * @brief Writes messages cells in batches like a generator, every cell holds the time it was written
+ * @param myshm The mapped shared memory object
+ * @param messages The number of cells to write
+ * @param batch The number of cells reserved at once
+*/
+static void runProducer(myshm *myshm, long messages, int batch) {
+  for (long sent = 0; sent < messages; ) {
+    int count = messages - sent < batch ? (int) (messages - sent) : batch;
+    unsigned long pos;
+    while (ringReserve(myshm, count, &pos) == -1) {
+      sched_yield();
+    }
+    for (int i = 0; i < count; i++) {
+      removedEdge *slot = getSlot(myshm, pos + i);
+      unsigned long stamp = getMonotonicNanos();
+      slot->numOfEdges = 1;
+      memcpy(slot->edges, &stamp, sizeof(stamp));
+    }
+    ringPublish(myshm, pos, count);
+    ringWakeConsumer(myshm);
+    sent += count;
+  }
+}
+
+/**
+ * Compares two latencies
+ * @return Returns a negative, zero or positive number like strcmp.
+*/
+static int compareLatencies(const void *a, const void *b) {
+  unsigned long x = *(const unsigned long *) a, y = *(const unsigned long *) b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * Runs the buffer benchmark
+ * @brief Forks the producers and consumes all their cells like the supervisor, then prints the throughput and the
+ * latency percentiles
+ * @param producers The number of producer processes
+ * @param messages The number of cells per producer
+ * @param batch The number of cells a producer reserves at once
+ * @param capacity The number of cells of the buffer
+ * @param policy How the consumer waits for an empty buffer
+*/
+static void benchRing(int producers, long messages, int batch, unsigned long capacity, waitPolicy policy) {
+  // The id of this process keeps the benchmark apart from real jobs
+  char job[MAX_JOB_NAME + 1];
+  snprintf(job, sizeof(job), "bench-%d", (int) getpid());
+  jobNames names;
+  initJobNames(&names, job);
+  int shmfd = createSHMFileDescriptor(&names, getSHMSize(capacity, 1));
+  myshm *myshm = createMappedSHMObject(shmfd);
+  initializeRing(myshm, capacity, 1);
+
+  long total = producers * messages, received = 0;
+  unsigned long *latencies = allocOrExit(total * sizeof(unsigned long));
+  int *pids = allocOrExit(producers * sizeof(int));
+  unsigned long start = getMonotonicNanos();
+  for (int p = 0; p < producers; p++) {
+    if ((pids[p] = fork()) == -1) {
+      printErrAndExit("Forking producer failed");
+    }
+    if (pids[p] == 0) {
+      runProducer(myshm, messages, batch);
+      _exit(EXIT_SUCCESS);
+    }
+  }
+
+  while (received < total) {
+    unsigned long available = ringAvailable(myshm);
+    if (available == 0) {
+      ringWaitConsumer(&myshm, 1, policy, -1);
+      continue;
+    }
+    unsigned long tail = __atomic_load_n(&myshm->tail, __ATOMIC_RELAXED);
+    unsigned long now = getMonotonicNanos();
+    for (unsigned long i = 0; i < available; i++) {
+      removedEdge *slot = getSlot(myshm, tail + i);
+      unsigned long stamp;
+      memcpy(&stamp, slot->edges, sizeof(stamp));
+      latencies[received++] = now - stamp;
+    }
+    ringRelease(myshm, available);
+  }
+  unsigned long elapsed = getMonotonicNanos() - start;
+  for (int p = 0; p < producers; p++) {
+    waitpid(pids[p], NULL, 0);
+  }
+
+  qsort(latencies, total, sizeof(unsigned long), compareLatencies);
+  static const char *policy_names[NUM_WAIT_POLICIES] = {"spin", "adaptive", "block"};
+  printf("{\"bench\":\"ring\",\"producers\":%d,\"batch\":%d,\"capacity\":%lu,\"policy\":\"%s\",\"messages\":%ld,"
+    "\"messages_per_sec\":%.0f,\"latency_p50_ns\":%lu,\"latency_p99_ns\":%lu,\"latency_max_ns\":%lu}\n",
+    producers, batch, capacity, policy_names[policy], total, total * 1e9 / elapsed,
+    latencies[total / 2], latencies[total * 99 / 100], latencies[total - 1]);
+  fflush(stdout);
+
+  free(latencies);
+  free(pids);
+  unmapSHM(myshm);
+  if (shm_unlink(names.shm) == -1) {
+    printErrAndExit("Unlinking SHM object failed");
+  }
+}
+
+/**
+ * Usage function
+ * @brief Prints the synopsis of the benchmark to stderr and exits
+ * @details global variables: pgm_name
+*/
+static void usage() {
+  (void) fprintf(stderr, "Usage: %s [-kernels | -ring] [-e max_edges] [-p producers] [-m messages] [-b batch] [-n slots] [-wait spin|adaptive|block]\n", pgm_name);
+  exit(EXIT_FAILURE);
+}
+
+/**
+ * Parse a number argument
+ * @brief Parses arg as a decimal number in the range [min, max]
+ * @details Calls usage() if the argument is not a number or out of range
+ * @param arg The argument string
+ * @param min The smallest accepted value
+ * @param max The largest accepted value
+ * @return Returns the parsed value.
+*/
+static long parseNumber(const char *arg, long min, long max) {
+  char *end;
+  errno = 0;
+  long value = strtol(arg, &end, 10);
+  if (*arg == '\0' || *end != '\0' || errno != 0 || value < min || value > max) {
+    usage();
+  }
+  return value;
+}
+
+/**
+ * Program entry point.
+ * @brief Runs the kernel benchmarks and then the buffer benchmark.
+ * @details -kernels or -ring runs only one of them.
+ * -e sets the largest benchmark graph (default DEFAULT_MAX_EDGES, the sizes are 1e3, 1e4, ... up to it).
+ * -p, -m and -b set the producers, the messages per producer and the batch size of the buffer benchmark,
+ * -n the number of cells of its buffer (default MAX_DATA) and -wait how it waits (default adaptive), see waitPolicy.
+ * global variables: pgm_name
+ * @param argc The argument counter.
+ * @param argv The argument vector.
+ * @return Returns EXIT_SUCCESS.
+ */
+int main(int argc, char **argv) {
+  pgm_name = argv[0];
+
+  int kernels = 1, ring = 1;
+  long max_edges = DEFAULT_MAX_EDGES, messages = DEFAULT_MESSAGES;
+  int producers = DEFAULT_PRODUCERS, batch = DEFAULT_BATCH, policy = WAIT_ADAPTIVE;
+  unsigned long capacity = MAX_DATA;
+  static const struct option long_options[] = {
+    {"kernels", no_argument, NULL, 'k'},
+    {"ring", no_argument, NULL, 'r'},
+    {"e", required_argument, NULL, 'e'},
+    {"p", required_argument, NULL, 'p'},
+    {"m", required_argument, NULL, 'm'},
+    {"b", required_argument, NULL, 'b'},
+    {"n", required_argument, NULL, 'n'},
+    {"wait", required_argument, NULL, 'w'},
+    {NULL, 0, NULL, 0}
+  };
+  int c;
+  while ((c = getopt_long_only(argc, argv, "e:p:m:b:n:", long_options, NULL)) != -1) {
+    switch (c) {
+      case 'k':
+        ring = 0;
+        break;
+      case 'r':
+        kernels = 0;
+        break;
+      case 'e':
+        max_edges = parseNumber(optarg, MIN_EDGES, INT_MAX);
+        break;
+      case 'p':
+        producers = parseNumber(optarg, 1, 1024);
+        break;
+      case 'm':
+        messages = parseNumber(optarg, 1, LONG_MAX / 1024);
+        break;
+      case 'b':
+        batch = parseNumber(optarg, 1, MAX_RING_SLOTS);
+        break;
+      case 'n':
+        capacity = parseNumber(optarg, 2, MAX_RING_SLOTS);
+        break;
+      case 'w':
+        if ((policy = parseWaitPolicy(optarg)) == -1) {
+          usage();
+        }
+        break;
+      default:
+        usage();
+    }
+  }
+  if (optind != argc || (!kernels && !ring) || (unsigned long) batch > capacity) {
+    usage();
+  }
+
+  rng r;
+  seedRng(&r, 1);
+  if (kernels) {
+    benchKernels(max_edges, &r);
+  }
+  if (ring) {
+    benchRing(producers, messages, batch, capacity, policy);
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,149 @@
+/**
+ * @file conflict.c
+ * @author Giancarlo Buenaflor <e51837398@tuwien.ac.at>
+ * @date 18.11.2020
+ * 
+ * @brief Implementation of the conflict module.
+ *
+ **/
+
+#include "conflict.h"
+
+/**
+ * Updates the membership of a vertex in the conflict set
+ * @param t The conflict table
+ * @param v The vertex whose conflicts may have changed
+*/
+static void updateConflictSet(conflictTable *t, int v) {
+  int in_set = t->conflict_pos[v] >= 0;
+  int conflicting = getVertexConflicts(t, v) > 0;
+  if (conflicting && !in_set) {
+    t->conflict_pos[v] = t->conflict_count;
+    t->conflict_set[t->conflict_count++] = v;
+  } else if (!conflicting && in_set) {
+    int last = t->conflict_set[--t->conflict_count];
+    t->conflict_set[t->conflict_pos[v]] = last;
+    t->conflict_pos[last] = t->conflict_pos[v];
+    t->conflict_pos[v] = -1;
+  }
+}
+
+/**
+ * Counts the self loops of a graph
+ * @param g The graph
+ * @return Returns the number of edges u-u, every other edge appears twice in the adjacency.
+*/
+static int countSelfLoops(const graph *g) {
+  return g->store.numOfEdges - g->adj.offsets[g->adj.numOfVertices] / 2;
+}
+
+size_t getConflictTableBytes(const graph *g) {
+  size_t n = g->store.numOfVertices;
+  return getArenaBytes(3 * n * sizeof(int)) + 2 * getArenaBytes(n * sizeof(int))
+         + getArenaBytes(countSelfLoops(g) * sizeof(int));
+}
+
+void initConflictTable(conflictTable *t, const graph *g, int *colors, arena *a) {
+  int n = g->store.numOfVertices;
+  t->g = g;
+  t->colors = colors;
+  t->neighbor_colors = arenaAlloc(a, 3 * (size_t) n * sizeof(int));
+  t->conflict_set = arenaAlloc(a, n * sizeof(int));
+  t->conflict_pos = arenaAlloc(a, n * sizeof(int));
+
+  t->self_loops = countSelfLoops(g);
+  t->self_loop_ids = arenaAlloc(a, t->self_loops * sizeof(int));
+  for (int e = 0, i = 0; e < g->store.numOfEdges; e++) {
+    if (getEdgeSource(&g->store, e) == getEdgeDestination(&g->store, e)) {
+      t->self_loop_ids[i++] = e;
+    }
+  }
+  resetConflictTable(t);
+}
+
+void resetConflictTable(conflictTable *t) {
+  const adjacency *adj = &t->g->adj;
+  int n = adj->numOfVertices, twice = 0;
+  memset(t->neighbor_colors, 0, 3 * (size_t) n * sizeof(int));
+  for (int v = 0; v < n; v++) {
+    int *counts = &t->neighbor_colors[3 * v];
+    for (int k = adj->offsets[v]; k < adj->offsets[v + 1]; k++) {
+      counts[t->colors[adj->neighbors[k]] - 1]++;
+    }
+  }
+  t->conflict_count = 0;
+  for (int v = 0; v < n; v++) {
+    t->conflict_pos[v] = -1;
+    updateConflictSet(t, v);
+    twice += getVertexConflicts(t, v);
+  }
+  t->conflicts = twice / 2 + t->self_loops;
+}
+
+void applyMove(conflictTable *t, int v, int c) {
+  int old = t->colors[v];
+  if (c == old) {
+    return;
+  }
+  const adjacency *adj = &t->g->adj;
+  t->conflicts += getMoveDelta(t, v, c);
+  t->colors[v] = c;
+  for (int k = adj->offsets[v]; k < adj->offsets[v + 1]; k++) {
+    int u = adj->neighbors[k];
+    t->neighbor_colors[3 * u + old - 1]--;
+    t->neighbor_colors[3 * u + c - 1]++;
+    if (t->colors[u] == old || t->colors[u] == c) {
+      updateConflictSet(t, u);
+    }
+  }
+  updateConflictSet(t, v);
+}
+
+int writeConflictEdges(const conflictTable *t, int bound, edge removed_edges[], int *removed_edges_count) {
+  if (t->conflicts > bound) {
+    return 0;
+  }
+  const adjacency *adj = &t->g->adj;
+  const edgeStore *store = &t->g->store;
+  int rem_count = 0;
+  for (int i = 0; i < t->self_loops; i++) {
+    int source = getEdgeSource(store, t->self_loop_ids[i]);
+    removed_edges[rem_count].destination = source;
+    removed_edges[rem_count].source = source;
+    rem_count++;
+  }
+  for (int i = 0; i < t->conflict_count; i++) {
+    int v = t->conflict_set[i];
+    for (int k = adj->offsets[v]; k < adj->offsets[v + 1]; k++) {
+      int u = adj->neighbors[k];
+      if (u > v && t->colors[u] == t->colors[v]) {
+        int e = adj->edge_ids[k];
+        removed_edges[rem_count].destination = getEdgeSource(store, e);
+        removed_edges[rem_count].source = getEdgeDestination(store, e);
+        rem_count++;
+      }
+    }
+  }
+  *removed_edges_count = rem_count;
+  return 1;
+}
+
+int listConflictIds(const conflictTable *t, int bound, int edge_ids[], int *edge_ids_count) {
+  if (t->conflicts > bound) {
+    return 0;
+  }
+  const adjacency *adj = &t->g->adj;
+  int count = t->self_loops;
+  memcpy(edge_ids, t->self_loop_ids, t->self_loops * sizeof(int));
+  for (int i = 0; i < t->conflict_count; i++) {
+    int v = t->conflict_set[i];
+    for (int k = adj->offsets[v]; k < adj->offsets[v + 1]; k++) {
+      int u = adj->neighbors[k];
+      if (u > v && t->colors[u] == t->colors[v]) {
+        edge_ids[count++] = adj->edge_ids[k];
+      }
+    }
+  }
+  *edge_ids_count = count;
+  return 1;
+}
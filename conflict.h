@@ -0,0 +1,116 @@
+/**
+ * @file conflict.h
+ * @author Giancarlo Buenaflor <e51837398@tuwien.ac.at>
+ * @date 18.11.2020
+ *
+ * @brief Provides incremental conflict counting for move-based searches.
+ *
+ * The conflict module. A conflictTable keeps, for every vertex, the number of neighbours holding each of the 3 colors.
+ * The cost of recoloring a vertex is then a difference of two table entries (O(1)), a move updates the table in
+ * O(deg(v)), and the conflicting edges can be listed from the set of conflicting vertices without scanning all edges.
+ */
+
+#ifndef CONFLICT_H
+#define CONFLICT_H
+
+#include "graph.h"
+#include "arena.h"
+
+/** Represents the conflict state of a coloring
+ * @brief colors is the coloring (1 to 3 per vertex, owned by the caller), conflicts its number of conflicting edges
+ * including self loops. neighbor_colors[3 * v + c - 1] is the number of neighbours of v with color c.
+ * The vertices with at least one conflicting neighbour form conflict_set (conflict_count entries), conflict_pos[v] is the
+ * index of v in it or -1. self_loop_ids holds the indices of the self_loops edges u-u, which always conflict.
+ */
+typedef struct conflictTable {
+  const graph *g;
+  int *colors;
+  int conflicts;
+  int *neighbor_colors;
+  int *conflict_set;
+  int *conflict_pos;
+  int conflict_count;
+  int self_loops;
+  int *self_loop_ids;
+} conflictTable;
+
+/**
+ * Initializes a conflict table
+ * @brief Allocates the table for g from the arena and computes it for colors
+ * @details The table lives until the arena is reset past it
+ * @param t The conflict table
+ * @param g The graph (must outlive the table)
+ * @param colors The coloring the table tracks (numOfVertices entries)
+ * @param a The arena of the worker
+*/
+void initConflictTable(conflictTable *t, const graph *g, int *colors, arena *a);
+
+/**
+ * Arena size of a conflict table
+ * @param g The graph
+ * @return Returns the number of arena bytes initConflictTable takes for g.
+*/
+size_t getConflictTableBytes(const graph *g);
+
+/**
+ * Recomputes a conflict table
+ * @brief Recomputes all counts after t->colors was changed from outside, O(V + E)
+ * @param t The conflict table
+*/
+void resetConflictTable(conflictTable *t);
+
+/**
+ * Number of conflicting edges at a vertex
+ * @param t The conflict table
+ * @param v The vertex
+ * @return Returns the number of neighbours of v with the color of v.
+*/
+static inline int getVertexConflicts(const conflictTable *t, int v) {
+  return t->neighbor_colors[3 * v + t->colors[v] - 1];
+}
+
+/**
+ * Cost of a move
+ * @param t The conflict table
+ * @param v The vertex
+ * @param c The new color
+ * @return Returns the change of t->conflicts if v is recolored to c.
+*/
+static inline int getMoveDelta(const conflictTable *t, int v, int c) {
+  return t->neighbor_colors[3 * v + c - 1] - t->neighbor_colors[3 * v + t->colors[v] - 1];
+}
+
+/**
+ * Recolors a vertex
+ * @brief Updates the counts of all neighbours and the conflict set in O(deg(v))
+ * @param t The conflict table
+ * @param v The vertex
+ * @param c The new color
+*/
+void applyMove(conflictTable *t, int v, int c);
+
+/**
+ * Lists the conflicting edges
+ * @brief Walks the adjacency of the conflicting vertices only, every edge is written once from its smaller end
+ * @details Edges are written like solveColorProblem does (source and destination swapped). Nothing is written
+ * if more than bound edges conflict. The ids are those of the graph, not mapped back to the input.
+ * @param t The conflict table
+ * @param bound The maximum number of removed edges that is still accepted
+ * @param removed_edges The removed_edges array that will be filled (at least bound entries)
+ * @param removed_edges_count The count for removed_edges (pointer, only set if the coloring is accepted)
+ * @return Returns 1 if at most bound edges conflict, 0 otherwise.
+*/
+int writeConflictEdges(const conflictTable *t, int bound, edge removed_edges[], int *removed_edges_count);
+
+/**
+ * Lists the indices of the conflicting edges
+ * @brief Like writeConflictEdges, but writes the index of every edge in the edge store (unsorted)
+ * @param t The conflict table
+ * @param bound The maximum number of removed edges that is still accepted
+ * @param edge_ids The array that will be filled (at least bound entries)
+ * @param edge_ids_count The count for edge_ids (pointer, only set if the coloring is accepted)
+ * @return Returns 1 if at most bound edges conflict, 0 otherwise.
+*/
+int listConflictIds(const conflictTable *t, int bound, int edge_ids[], int *edge_ids_count);
+
+#endif
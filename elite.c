@@ -0,0 +1,253 @@
+/**
+ * @file elite.c
+ * @author Giancarlo Buenaflor <e51837398@tuwien.ac.at>
+ * @date 18.11.2020
+ *
+ * @brief Implementation of the elite module.
+ *
+ **/
+
+#include <errno.h>
+#include <limits.h>
+#include "elite.h"
+#include "random.h"
+
+/** Maximum time in milliseconds a generator waits for another one to initialize the elite object */
+#define ELITE_READY_TIMEOUT_MS (1000)
+
+/** Number of times a reader copies a member before it gives up on a busy writer */
+#define ELITE_READ_RETRIES (4)
+
+/**
+ * Computes the layout of a pool
+ * @param pool The header to fill (numOfVertices and capacity set)
+*/
+static void layoutPool(elitePool *pool) {
+  size_t words = getPackedWords(pool->numOfVertices);
+  pool->member_size = (sizeof(eliteMember) + words * sizeof(uint64_t) + CACHE_LINE - 1) & ~((size_t) CACHE_LINE - 1);
+  pool->size = sizeof(elitePool) + (size_t) pool->capacity * pool->member_size;
+}
+
+/**
+ * Initializes a new pool
+ * @brief Writes the header and empties every member, publishes the pool with ready last
+ * @param pool The mapped pool (zeroed)
+ * @param layout The header
+*/
+static void initPool(elitePool *pool, const elitePool *layout) {
+  memcpy(pool, layout, sizeof(elitePool));
+  for (int k = 0; k < pool->capacity; k++) {
+    getEliteMember(pool, k)->cost = INT_MAX;
+  }
+  __atomic_store_n(&pool->ready, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Maps an existing elite object
+ * @brief Waits until its creator initialized it and checks that it belongs to the graph
+ * @param name The name of the elite object
+ * @param layout The header the pool must have (apart from the capacity)
+ * @return Returns the pool, or NULL if it belongs to another graph or wasn't initialized in time.
+*/
+static elitePool *attachPool(const char *name, const elitePool *layout) {
+  int shmfd = shm_open(name, O_RDWR, 0600);
+  if (shmfd == -1) {
+    printErrAndExit("Couldn't open SHM elite object");
+  }
+  struct stat st;
+  for (int waited = 0; ; waited++) {
+    if (fstat(shmfd, &st) == -1) {
+      printErrAndExit("Stat SHM elite object failed");
+    }
+    // The creator may not have truncated the object yet
+    if ((size_t) st.st_size >= sizeof(elitePool)) {
+      break;
+    }
+    if (waited >= ELITE_READY_TIMEOUT_MS) {
+      close(shmfd);
+      return NULL;
+    }
+    usleep(1000);
+  }
+  elitePool *pool = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, shmfd, 0);
+  if (pool == MAP_FAILED) {
+    printErrAndExit("Mapping SHM elite object failed");
+  }
+  close(shmfd);
+
+  for (int waited = 0; __atomic_load_n(&pool->ready, __ATOMIC_ACQUIRE) == 0; waited++) {
+    if (waited >= ELITE_READY_TIMEOUT_MS) {
+      munmap(pool, st.st_size);
+      return NULL;
+    }
+    usleep(1000);
+  }
+  if (pool->graph_hash != layout->graph_hash || pool->numOfVertices != layout->numOfVertices
+      || pool->size != (size_t) st.st_size) {
+    munmap(pool, st.st_size);
+    return NULL;
+  }
+  return pool;
+}
+
+elitePool *openElitePool(const char *name, int capacity, const graph *g) {
+  elitePool layout = {
+    .numOfVertices = g->store.numOfVertices,
+    .capacity = capacity,
+    .graph_hash = name != NULL ? ((const graphHeader *) g->mapping)->hash : 0
+  };
+  layoutPool(&layout);
+
+  if (name == NULL) {
+    elitePool *pool = mmap(NULL, layout.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pool == MAP_FAILED) {
+      printErrAndExit("Allocating elite pool failed");
+    }
+    initPool(pool, &layout);
+    return pool;
+  }
+
+  int shmfd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (shmfd == -1) {
+    if (errno != EEXIST) {
+      printErrAndExit("SHM elite object failed creation");
+    }
+    return attachPool(name, &layout);
+  }
+  if (ftruncate(shmfd, layout.size) < 0) {
+    printErrAndExit("Truncate SHM elite object failed");
+  }
+  elitePool *pool = mmap(NULL, layout.size, PROT_READ | PROT_WRITE, MAP_SHARED, shmfd, 0);
+  if (pool == MAP_FAILED) {
+    printErrAndExit("Mapping SHM elite object failed");
+  }
+  close(shmfd);
+  initPool(pool, &layout);
+  return pool;
+}
+
+void closeElitePool(elitePool *pool) {
+  if (pool != NULL) {
+    munmap(pool, pool->size);
+  }
+}
+
+/**
+ * Packs one word of a renamed coloring
+ * @brief Renames the colors in the order of their first vertex (rename[c] is 0 for a color not seen yet)
+ * @param colors The coloring
+ * @param n The number of vertices
+ * @param w The index of the word
+ * @param rename The renaming so far (updated)
+ * @return Returns the word.
+*/
+static uint64_t packWord(const int colors[], int n, int w, int rename[4]) {
+  uint64_t word = 0;
+  int end = (w + 1) * PACKED_COLORS_PER_WORD < n ? (w + 1) * PACKED_COLORS_PER_WORD : n;
+  for (int v = w * PACKED_COLORS_PER_WORD; v < end; v++) {
+    int c = colors[v];
+    if (rename[c] == 0) {
+      rename[c] = ++rename[0];
+    }
+    word |= (uint64_t) rename[c] << (2 * (v % PACKED_COLORS_PER_WORD));
+  }
+  return word;
+}
+
+/**
+ * Hashes a renamed coloring
+ * @brief FNV-1a over the packed words
+ * @param colors The coloring
+ * @param n The number of vertices
+ * @return Returns the hash.
+*/
+static uint64_t hashColoring(const int colors[], int n) {
+  // rename[0] counts the colors seen so far
+  int rename[4] = {0};
+  uint64_t hash = 14695981039346656037ULL;
+  for (int w = 0; w < getPackedWords(n); w++) {
+    hash = (hash ^ packWord(colors, n, w, rename)) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+int offerElite(elitePool *pool, const int colors[], int cost) {
+  int worst = -1, worst_cost = cost;
+  for (int k = 0; k < pool->capacity; k++) {
+    int member_cost = __atomic_load_n(&getEliteMember(pool, k)->cost, __ATOMIC_RELAXED);
+    if (member_cost > worst_cost) {
+      worst = k, worst_cost = member_cost;
+    }
+  }
+  if (worst == -1) {
+    return 0;
+  }
+  int n = pool->numOfVertices;
+  uint64_t hash = hashColoring(colors, n);
+  for (int k = 0; k < pool->capacity; k++) {
+    eliteMember *member = getEliteMember(pool, k);
+    if (__atomic_load_n(&member->cost, __ATOMIC_RELAXED) == cost && __atomic_load_n(&member->hash, __ATOMIC_RELAXED) == hash) {
+      return 0;
+    }
+  }
+
+  eliteMember *member = getEliteMember(pool, worst);
+  unsigned long sequence = __atomic_load_n(&member->sequence, __ATOMIC_RELAXED);
+  if ((sequence & 1) != 0 || !__atomic_compare_exchange_n(&member->sequence, &sequence, sequence + 1, 0,
+                                                          __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+    return 0;
+  }
+  // Another writer may have replaced the member since it was chosen
+  if (__atomic_load_n(&member->cost, __ATOMIC_RELAXED) <= cost) {
+    __atomic_store_n(&member->sequence, sequence, __ATOMIC_RELEASE);
+    return 0;
+  }
+  // Readers that see a word of the new coloring also see the odd sequence
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  int rename[4] = {0};
+  for (int w = 0; w < getPackedWords(n); w++) {
+    __atomic_store_n(&member->packed[w], packWord(colors, n, w, rename), __ATOMIC_RELAXED);
+  }
+  __atomic_store_n(&member->hash, hash, __ATOMIC_RELAXED);
+  __atomic_store_n(&member->cost, cost, __ATOMIC_RELAXED);
+  __atomic_store_n(&member->sequence, sequence + 2, __ATOMIC_RELEASE);
+  return 1;
+}
+
+int readElite(const elitePool *pool, int k, int colors[]) {
+  eliteMember *member = getEliteMember(pool, k);
+  int n = pool->numOfVertices;
+  for (int retry = 0; retry < ELITE_READ_RETRIES; retry++) {
+    unsigned long before = __atomic_load_n(&member->sequence, __ATOMIC_ACQUIRE);
+    if ((before & 1) != 0) {
+      continue;
+    }
+    int cost = __atomic_load_n(&member->cost, __ATOMIC_RELAXED);
+    if (cost == INT_MAX) {
+      return -1;
+    }
+    for (int w = 0; w < getPackedWords(n); w++) {
+      uint64_t word = __atomic_load_n(&member->packed[w], __ATOMIC_RELAXED);
+      int end = (w + 1) * PACKED_COLORS_PER_WORD < n ? (w + 1) * PACKED_COLORS_PER_WORD : n;
+      for (int v = w * PACKED_COLORS_PER_WORD; v < end; v++, word >>= 2) {
+        colors[v] = word & 3;
+      }
+    }
+    // The copy is complete if no writer started meanwhile
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&member->sequence, __ATOMIC_RELAXED) == before) {
+      return cost;
+    }
+  }
+  return -1;
+}
+
+int findElite(const elitePool *pool, int start) {
+  for (int i = 0; i < pool->capacity; i++) {
+    int k = (start + i) % pool->capacity;
+    if (__atomic_load_n(&getEliteMember(pool, k)->cost, __ATOMIC_RELAXED) != INT_MAX) {
+      return k;
+    }
+  }
+  return -1;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file elite.h
+ * @author Giancarlo Buenaflor <e51837398@tuwien.ac.at>
+ * @date 18.11.2020
+ *
+ * @brief Provides the elite pool the generators of a job share their best colorings through.
+ *
+ * The elite module. The pool holds the capacity colorings with the fewest conflicts any worker offered, packed with 2
+ * bits per vertex (see random.h) and with the colors renamed in the order of their first vertex, so the same coloring
+ * under other color names is recognized as a duplicate. Local searches restart from a perturbed member or from the
+ * crossover of two members instead of from scratch (see search.h).
+ * Every member is guarded by its own seqlock: a writer claims it with a compare-and-swap that makes its sequence odd and
+ * gives up if another writer holds it, readers copy the member and retry if the sequence changed meanwhile. Neither
+ * side ever waits for the other, so the pool costs the search loop nothing.
+ * The pool of a shared graph lives in the elite object of the job (SHM_ELITE_NAME), created by the first generator
+ * that maps the graph. Generators with a private graph share a private pool among their workers.
+ */
+
+#ifndef ELITE_H
+#define ELITE_H
+
+#include <stdint.h>
+#include "graph.h"
+
+/** Default number of colorings of the elite pool */
+#define DEFAULT_ELITE (8)
+
+/** Maximum number of colorings of the elite pool */
+#define MAX_ELITE (64)
+
+/** Represents a coloring of the elite pool
+ * @brief sequence is odd while a writer changes the member. cost is the number of conflicts of the coloring (INT_MAX
+ * for an empty member), hash identifies the renamed coloring, packed holds it (getPackedWords(numOfVertices) words).
+ * Members are pool->member_size bytes apart.
+ */
+typedef struct eliteMember {
+  unsigned long sequence;
+  int cost;
+  uint64_t hash;
+  uint64_t packed[];
+} eliteMember;
+
+/** Represents the mapping of an elite pool
+ * @brief ready is set once the creator initialized every member. numOfVertices and graph_hash tell the graph the
+ * colorings belong to (graph_hash is 0 for a private pool). size is the size of the whole mapping in bytes.
+ */
+typedef struct elitePool {
+  int ready;
+  int numOfVertices;
+  int capacity;
+  uint64_t graph_hash;
+  size_t member_size;
+  size_t size;
+  unsigned char members[] __attribute__((aligned(CACHE_LINE)));
+} elitePool;
+
+/**
+ * Opens an elite pool
+ * @brief Maps the elite object of the job, creating it if it doesn't exist yet, or creates a private pool
+ * @details The creator decides the capacity, the others use the pool as they find it. If creating or mapping the pool
+ * fails, the program prints an error and exits
+ * @param name The name of the elite object, see jobNames, or NULL for a private pool
+ * @param capacity The number of colorings (1 to MAX_ELITE) if the pool is created
+ * @param g The graph of the colorings, mapped from the shared graph unless name is NULL
+ * @return Returns the pool, or NULL if the elite object belongs to another graph.
+*/
+elitePool *openElitePool(const char *name, int capacity, const graph *g);
+
+/**
+ * Closes an elite pool
+ * @param pool The pool (may be NULL)
+*/
+void closeElitePool(elitePool *pool);
+
+/**
+ * Offers a coloring to an elite pool
+ * @brief Replaces the member with the most conflicts if the coloring has fewer and isn't in the pool yet
+ * @details Gives up instead of waiting if another writer holds that member
+ * @param pool The pool
+ * @param colors The coloring (1 to 3 per vertex)
+ * @param cost The number of conflicts of the coloring
+ * @return Returns 1 if the coloring was added, 0 otherwise.
+*/
+int offerElite(elitePool *pool, const int colors[], int cost);
+
+/**
+ * Reads a coloring of an elite pool
+ * @brief Copies member k into colors under its seqlock
+ * @details colors may be overwritten even if the read fails
+ * @param pool The pool
+ * @param k The index of the member (0 to pool->capacity - 1)
+ * @param colors The coloring to fill (1 to 3 per vertex)
+ * @return Returns the number of conflicts of the coloring, or -1 if the member is empty or kept changing.
+*/
+int readElite(const elitePool *pool, int k, int colors[]);
+
+/**
+ * Finds a coloring of an elite pool
+ * @param pool The pool
+ * @param start The index to start from (0 to pool->capacity - 1)
+ * @return Returns the index of the first member from start on that isn't empty (wrapping around), or -1 if all are.
+*/
+int findElite(const elitePool *pool, int start);
+
+/**
+ * Returns a member of an elite pool
+ * @param pool The pool
+ * @param k The index of the member
+ * @return Returns a pointer to the member.
+*/
+static inline eliteMember *getEliteMember(const elitePool *pool, int k) {
+  return (eliteMember *) (pool->members + (size_t) k * pool->member_size);
+}
+
+#endif
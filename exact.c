@@ -0,0 +1,184 @@
+/**
+ * @file exact.c
+ * @author Giancarlo Buenaflor <e51837398@tuwien.ac.at>
+ * @date 18.11.2020
+ *
+ * @brief Implementation of the exact module.
+ *
+ **/
+
+#include "exact.h"
+
+/** Number of nodes at the split depth per worker, the deeper the split the more even the parts */
+#define SPLIT_NODES_PER_WORKER (32)
+
+/**
+ * Fewest conflicts of an uncolored vertex
+ * @param e The exact search
+ * @param v The vertex
+ * @return Returns the smallest number of colored neighbours sharing one color.
+*/
+static int fewestConflicts(const exactSearch *e, int v) {
+  const int *count = &e->counts[3 * v];
+  int min = count[0] < count[1] ? count[0] : count[1];
+  return min < count[2] ? min : count[2];
+}
+
+/**
+ * Colors a vertex
+ * @brief Adds its conflicts to the cost and updates the counts and the slack of its neighbours
+ * @param e The exact search
+ * @param v The uncolored vertex
+ * @param c The color
+*/
+static void colorVertex(exactSearch *e, int v, int c) {
+  const adjacency *adj = e->adj;
+  e->cost += e->counts[3 * v + c - 1];
+  e->slack -= fewestConflicts(e, v);
+  e->colors[v] = c;
+  for (int k = adj->offsets[v]; k < adj->offsets[v + 1]; k++) {
+    int u = adj->neighbors[k];
+    if (e->colors[u] == 0) {
+      int before = fewestConflicts(e, u);
+      e->counts[3 * u + c - 1]++;
+      e->slack += fewestConflicts(e, u) - before;
+    } else {
+      e->counts[3 * u + c - 1]++;
+    }
+  }
+}
+
+/**
+ * Uncolors a vertex
+ * @brief Undoes colorVertex
+ * @param e The exact search
+ * @param v The colored vertex
+*/
+static void uncolorVertex(exactSearch *e, int v) {
+  const adjacency *adj = e->adj;
+  int c = e->colors[v];
+  e->colors[v] = 0;
+  for (int k = adj->offsets[v]; k < adj->offsets[v + 1]; k++) {
+    int u = adj->neighbors[k];
+    if (e->colors[u] == 0) {
+      int before = fewestConflicts(e, u);
+      e->counts[3 * u + c - 1]--;
+      e->slack += fewestConflicts(e, u) - before;
+    } else {
+      e->counts[3 * u + c - 1]--;
+    }
+  }
+  e->slack += fewestConflicts(e, v);
+  e->cost -= e->counts[3 * v + c - 1];
+}
+
+/**
+ * Places the next vertex
+ * @brief Chooses the uncolored vertex with the most distinct neighbour colors (ties by degree) for depth d and orders
+ * its colors by the conflicts they add (ties by color), of the unused colors only the first is an option
+ * @param e The exact search
+ * @param d The depth (below n)
+*/
+static void placeVertex(exactSearch *e, int d) {
+  int best = -1, best_saturation = -1, best_degree = -1;
+  for (int v = 0; v < e->n; v++) {
+    if (e->colors[v] != 0) {
+      continue;
+    }
+    const int *count = &e->counts[3 * v];
+    int saturation = (count[0] > 0) + (count[1] > 0) + (count[2] > 0);
+    int degree = getDegree(e->adj, v);
+    if (saturation > best_saturation || (saturation == best_saturation && degree > best_degree)) {
+      best = v, best_saturation = saturation, best_degree = degree;
+    }
+  }
+  e->vertices[d] = best;
+
+  unsigned char *options = &e->options[3 * d];
+  int num_options = e->used[d] < 3 ? e->used[d] + 1 : 3;
+  for (int i = 0; i < num_options; i++) {
+    // Insertion sort by the number of conflicts, stable so smaller colors come first
+    int c = i + 1, j = i;
+    while (j > 0 && e->counts[3 * best + options[j - 1] - 1] > e->counts[3 * best + c - 1]) {
+      options[j] = options[j - 1];
+      j--;
+    }
+    options[j] = c;
+  }
+  e->num_options[d] = num_options;
+  e->next[d] = 0;
+}
+
+size_t getExactSearchBytes(int numOfVertices) {
+  size_t n = numOfVertices;
+  return 4 * getArenaBytes(n * sizeof(int)) + getArenaBytes(3 * n * sizeof(int)) + getArenaBytes(3 * n)
+         + getArenaBytes((n + 1) * sizeof(int));
+}
+
+void initExactSearch(exactSearch *e, const graph *g, int worker, int num_workers, arena *a) {
+  int n = g->store.numOfVertices;
+  memset(e, 0, sizeof(exactSearch));
+  e->adj = &g->adj;
+  e->n = n;
+  // Every edge except the self loops appears twice in the adjacency
+  e->self_loops = g->store.numOfEdges - g->adj.offsets[g->adj.numOfVertices] / 2;
+  e->colors = arenaAlloc(a, n * sizeof(int));
+  e->counts = arenaAlloc(a, 3 * (size_t) n * sizeof(int));
+  e->vertices = arenaAlloc(a, n * sizeof(int));
+  e->options = arenaAlloc(a, 3 * (size_t) n);
+  e->num_options = arenaAlloc(a, n * sizeof(int));
+  e->next = arenaAlloc(a, n * sizeof(int));
+  e->used = arenaAlloc(a, (n + 1) * sizeof(int));
+  e->worker = worker;
+  e->num_workers = num_workers;
+  if (num_workers > 1) {
+    // Below the split depth the tree has at least 3^(depth - 1) nodes, the first vertex only gets color 1
+    unsigned long nodes = 1;
+    e->split_depth = 1;
+    while (e->split_depth < n && nodes < SPLIT_NODES_PER_WORKER * (unsigned long) num_workers) {
+      nodes *= 3;
+      e->split_depth++;
+    }
+  }
+  if (n > 0) {
+    placeVertex(e, 0);
+  }
+}
+
+int exactStep(exactSearch *e, int bound, long budget, int colors[]) {
+  for (; budget > 0 && e->depth >= 0; budget--) {
+    int d = e->depth;
+    if (d == e->n) {
+      // Complete, the last vertex is uncolored on the way back up
+      e->depth--;
+      int total = e->cost + e->self_loops;
+      if (total < bound) {
+        memcpy(colors, e->colors, e->n * sizeof(int));
+        return total;
+      }
+      continue;
+    }
+    int v = e->vertices[d];
+    if (e->colors[v] != 0) {
+      uncolorVertex(e, v);
+    }
+    if (e->next[d] == e->num_options[d]) {
+      e->depth--;
+      continue;
+    }
+    int c = e->options[3 * d + e->next[d]++];
+    colorVertex(e, v, c);
+    if (d + 1 == e->split_depth && e->split_count++ % e->num_workers != (unsigned long) e->worker) {
+      continue;
+    }
+    if (d + 1 >= e->split_depth && e->cost + e->slack + e->self_loops >= bound) {
+      continue;
+    }
+    e->used[d + 1] = c > e->used[d] ? c : e->used[d];
+    if (d + 1 < e->n) {
+      placeVertex(e, d + 1);
+    }
+    e->depth = d + 1;
+  }
+  return bound;
+}
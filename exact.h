@@ -0,0 +1,92 @@
+/**
+ * @file exact.h
+ * @author Giancarlo Buenaflor <e51837398@tuwien.ac.at>
+ * @date 18.11.2020
+ *
+ * @brief Provides the exact branch-and-bound search of the generator.
+ *
+ * The exact module. The vertices are colored one at a time in DSatur order (the vertex with the most distinct colors
+ * among its colored neighbours, ties by degree), every color is tried in the order of the fewest conflicts it adds.
+ * A partial coloring is pruned once its conflicts plus, for every uncolored vertex, the fewest conflicts any of its
+ * colors would add reach the bound. Colors are interchangeable, so a vertex only gets a new color if all smaller ones
+ * are in use. Once the whole tree was visited, no coloring below the last bound exists.
+ * The search is resumable and advances a bounded number of nodes at a time. Several workers split the tree: the nodes
+ * at depth split_depth are dealt out round-robin and nothing above that depth is pruned, so every worker sees the same nodes.
+ */
+
+#ifndef EXACT_H
+#define EXACT_H
+
+#include "graph.h"
+#include "arena.h"
+
+/** Represents the state of an exact search
+ * @brief colors is the partial coloring (0 for an uncolored vertex), counts[3 * v + c - 1] the number of colored
+ * neighbours of v with color c. At depth d, vertices[d] is the vertex being colored, options[3 * d] to
+ * options[3 * d + num_options[d] - 1] its colors in the order they are tried and next[d] the index of the next one.
+ * used[d] is the number of colors in use above depth d. cost is the number of conflicts of the partial coloring,
+ * slack the sum of the fewest conflicts of every uncolored vertex, self_loops the constant cost of self loops.
+ * depth is n once the coloring is complete and -1 once the tree is exhausted.
+ * worker and num_workers select the part of the tree, split_count counts the nodes at split_depth (0: no split).
+ */
+typedef struct exactSearch {
+  const adjacency *adj;
+  int n;
+  int self_loops;
+  int *colors;
+  int *counts;
+  int *vertices;
+  unsigned char *options;
+  int *num_options;
+  int *next;
+  int *used;
+  int depth;
+  int cost;
+  int slack;
+  int worker;
+  int num_workers;
+  int split_depth;
+  unsigned long split_count;
+} exactSearch;
+
+/**
+ * Initializes an exact search
+ * @brief Allocates the state from the arena and places the first vertex at the root
+ * @details The state lives until the arena is reset past it
+ * @param e The exact search
+ * @param g The graph (must outlive the search)
+ * @param worker The index of this worker (0 to num_workers - 1)
+ * @param num_workers The number of workers sharing the tree
+ * @param a The arena of the worker
+*/
+void initExactSearch(exactSearch *e, const graph *g, int worker, int num_workers, arena *a);
+
+/**
+ * Arena size of an exact search
+ * @param numOfVertices The number of vertices
+ * @return Returns the number of arena bytes initExactSearch takes.
+*/
+size_t getExactSearchBytes(int numOfVertices);
+
+/**
+ * Advances an exact search
+ * @brief Visits up to budget nodes until it finds a complete coloring with fewer than bound conflicts
+ * @details The bound may only decrease between calls.
+ * @param e The exact search
+ * @param bound The cost a coloring must undercut
+ * @param budget The maximum number of nodes to visit
+ * @param colors The coloring (1 to 3 per vertex, only written if one is found)
+ * @return Returns the cost of the coloring written to colors, or a value >= bound.
+*/
+int exactStep(exactSearch *e, int bound, long budget, int colors[]);
+
+/**
+ * Tells whether an exact search is exhausted
+ * @param e The exact search
+ * @return Returns 1 if the search visited its whole part of the tree, 0 otherwise.
+*/
+static inline int isExactExhausted(const exactSearch *e) {
+  return e->depth == -1;
+}
+
+#endif
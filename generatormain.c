@@ -6,10 +6,12 @@
  * @brief Main program module.
  * 
  * This program "generator" acts as the client. It will randomize color for a parsed graph through the arguments and create solution for the 3-color problem
- * It will write to the circular buffer and semaphores act as a synchronizer so multiple generator don't write to the same space.
+ * It will write to the lock-free circular buffer, multiple generators claim cells with atomic operations so they never write to the same space.
+ * One generator process runs several worker threads on the same read-only edge array, each with its own random number generator.
  * 
 **/
- 
+
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -21,68 +23,584 @@
 #include <semaphore.h>
 #include <signal.h>
 #include <errno.h>
+#include <sched.h>
+#include <stdint.h>
+#include <limits.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
 #include "sharedmem.h"
+#include "random.h"
+#include "graph.h"
+#include "kernel.h"
+#include "search.h"
+#include "solution.h"
+#include "net.h"
+#include "elite.h"
+#include "arena.h"
+
+#define MAX_THREADS (1024)
+
+/** Default and maximum number of solutions a worker submits with one reservation */
+#define DEFAULT_BATCH (8)
+#define MAX_BATCH (256)
 
-/** Stores the semaphore indicating used spots in our circular buffer. 
- * @brief If used_sem is 0 then the generator won't be able to write onto the buffer
+/** Represents the state shared by all worker threads of this generator
+ * @brief The graph and the mapped shared memory object are read-only for the workers
+ * graph holds the edges in structure-of-arrays layout (possibly mapped from the shared graph), kernel is the conflict kernel selected for it.
+ * graph.old_id maps the vertex ids of a renumbered graph back to the ids of the input (NULL if it was not renumbered)
+ * strategy is the search strategy all workers run, starting from a seed coloring
+ * process_best is the best solution any worker of this process has written so far
+ * batch is the maximum number of solutions a worker collects before writing them to the buffer at once
+ * compact is set if graph is the shared graph, solutions are then sent as packed coloring or edge indices (see solution.h)
+ * instead of edge pairs. coloring_bytes is the size of a packed coloring, index_limit the largest index encoding worth
+ * trying (the smaller of coloring_bytes and the payload of a cell, or 0 without compact)
+ * num_workers is the number of workers, exhausted the number of them whose exact search is exhausted and proven the
+ * smallest bound they proved (see isSearchExhausted).
+ * pool is the elite pool the workers share their colorings through (NULL with -elite 0), see elite.h.
+ * pid is the process id written into every cell, entry is the registry entry of this process (NULL if the registry is full or the buffer is private), see registerGenerator
  */
-static sem_t *used_sem;
+typedef struct generatorContext {
+  graph graph;
+  conflictKernel kernel;
+  strategyType strategy;
+  seedType seed;
+  int numOfVertices;
+  myshm *myshm;
+  int max_edges;
+  int process_best;
+  int batch;
+  int compact;
+  size_t coloring_bytes;
+  size_t index_limit;
+  generatorEntry *entry;
+  elitePool *pool;
+  int pid;
+  int num_workers;
+  int exhausted;
+  int proven;
+} generatorContext;
 
-/** Stores the semaphore indicating free spots in our circular buffer. 
- * @brief If free_sem is 0 then the generator won't be able to read from the buffer
+/** Represents a worker thread
+ * @brief Every worker owns its random number generator, its search state and the arena the search state lives in
+ * cpu is the core the worker is pinned to, or -1 if it is not pinned
  */
-static sem_t *free_sem;
+typedef struct worker {
+  pthread_t thread;
+  int id;
+  int cpu;
+  rng rng;
+  generatorContext *ctx;
+} worker;
 
-/** Stores the semaphore used for synchronizing mutual access to a space
- * @brief If two processes try to manipulate a mutual variable, this semaphore will synchronize a correct behaviour
+/** Represents the connection of a generator started with -c
+ * @brief The workers write into ring, a private circular buffer with the geometry of the remote job, so they use the
+ * same claimBuff and writeBuff as on the shared buffer. sender is its consumer and forwards the solutions to the
+ * supervisor, receiver lowers ring->best_solution on NET_BEST broadcasts and sets ring->state once the job ends.
  */
-static sem_t *mutex_sem;
+typedef struct remoteLink {
+  int fd;
+  myshm *ring;
+  pthread_t sender;
+  pthread_t receiver;
+} remoteLink;
+
+/** Stores an atomic variable quit
+ * @brief Set by SIGINT or SIGTERM, the workers then write their pending solutions and the generator unregisters
+ */
+static volatile sig_atomic_t quit = 0;
+
+/**
+ * Handle signal
+ * @brief Sets quit, so the generator terminates after the current search step
+ * @param signal The type of signal received.
+*/
+static void handle_signal(int signal) {
+  quit = 1;
+}
 
-/** Stores the current write position in our buffer. 
- * @brief This variable is set inside the "writeBuff(..)" function and represents the current write position
+/** Stores the semaphore that marks the circular buffer as ready
+ * @brief The supervisor creates it last, it is never posted (the supervisor sleeps on the futex myshm->sleeping)
  */
-static int wr_pos = 0;
+static sem_t *used_sem;
+
+/**
+ * Claim buffer function
+ * @brief This function reserves consecutive cells of the circular buffer, the solutions are written straight into them.
+ * @details If the buffer is too full, the generator yields and retries until enough cells are free or the supervisor terminates.
+ * @param myshm The mapped shared memory object.
+ * @param count The number of cells (1 to myshm->capacity).
+ * @param pos The position of the first cell (pointer, set on success).
+ * @param blocked_ns The time spent waiting for free cells in nanoseconds (pointer, increased, the clock is only read if the buffer is full).
+ * @return Returns 0 on success, -1 if the supervisor or this generator terminated.
+*/
+static int claimBuff(myshm *myshm, int count, unsigned long *pos, unsigned long *blocked_ns) {
+  if (ringReserve(myshm, count, pos) == 0) {
+    return 0;
+  }
+  unsigned long start = getMonotonicNanos();
+  int result = 0;
+  while (ringReserve(myshm, count, pos) == -1) {
+    if (__atomic_load_n(&myshm->state, __ATOMIC_ACQUIRE) == 1 || quit) {
+      result = -1;
+      break;
+    }
+    sched_yield();
+  }
+  *blocked_ns += getMonotonicNanos() - start;
+  return result;
+}
 
 /**
- * Read buffer function
- * @brief This function reads the circular buffer in our shared memory object.
- * @details Only reads if free_sem is > 0
- * @param val A removedEdge array that represents the circular buffer.
- * @param removed_edges A edge array that represents the arrays that should be removed to make the graph 3-colorable.
- * @param edges_to_write A removedEdge array that represents the circular buffer.
+ * Write buffer function
+ * @brief This function hands the cells reserved with claimBuff to the supervisor.
+ * @details The first used cells hold solutions, the remaining cells are abandoned. All are published with a single store.
+ * @param myshm The mapped shared memory object.
+ * @param pos The position of the first cell.
+ * @param used The number of cells holding a solution.
+ * @param count The number of reserved cells.
 */
-static void writeBuff(int val, edge removed_edges[], removedEdge edges_to_write[]) {
-  sem_wait(free_sem);
-  edges_to_write[wr_pos].numOfEdges = val;
-  for (int j = 0; j < val; j++) {
-    edges_to_write[wr_pos].edges[j].source = removed_edges[j].source;
-    edges_to_write[wr_pos].edges[j].destination = removed_edges[j].destination;
+static void writeBuff(myshm *myshm, unsigned long pos, int used, int count) {
+  for (int i = used; i < count; i++) {
+    getSlot(myshm, pos + i)->numOfEdges = RING_ABANDONED;
   }
-  sem_post(used_sem);
-  wr_pos += 1;
-  wr_pos %= sizeof(edges_to_write);
+  ringPublish(myshm, pos, count);
+  ringWakeConsumer(myshm);
 }
 
 /**
  * Initialize semaphores function
- * @brief This function attempts to initialize semaphores used to synchronize between this generator and the supervisor
- * @details Three essential semaphores are initialized that are necessary for synchronizing the circular buffer read and write
+ * @brief This function attempts to open the semaphore that marks the circular buffer as ready
+ * @details The supervisor creates USED_SEM after initializing the circular buffer, so opening it succeeds only on a ready buffer
+ * @param names The object names of the job
 */
-static void initializeSemaphores() {
-  used_sem = sem_open(USED_SEM, 0);
+static void initializeSemaphores(const jobNames *names) {
+  used_sem = sem_open(names->used_sem, 0);
   if(used_sem == SEM_FAILED) {
     printErrAndExit("USED_SEM failed creation");
 	}
+}
 
-  free_sem = sem_open(FREE_SEM, 0);
-  if(free_sem == SEM_FAILED) {
-    printErrAndExit("FREE_SEM failed creation");
-	}
+/**
+ * Stops a remote connection
+ * @brief Sets the state of the private buffer to 1 and wakes the sender
+ * @details The sender may be about to sleep on the empty buffer, so an abandoned cell is published to wake it.
+ * If the buffer is full the sender is busy and sees the state on its next round.
+ * @param link The connection
+*/
+static void stopRemote(remoteLink *link) {
+  myshm *ring = link->ring;
+  unsigned long pos;
+  __atomic_store_n(&ring->state, 1, __ATOMIC_RELEASE);
+  if (ringReserve(ring, 1, &pos) == 0) {
+    getSlot(ring, pos)->numOfEdges = RING_ABANDONED;
+    ringPublish(ring, pos, 1);
+  }
+  ringWakeConsumer(ring);
+}
 
-  mutex_sem = sem_open(MUTEX_SEM, 0);
-  if(mutex_sem == SEM_FAILED) {
-    printErrAndExit("MUTEX_SEM failed creation");
-	}
+/**
+ * Sender thread function
+ * @brief Forwards the solutions of the private buffer to the supervisor
+ * @details Solutions that lost against a broadcast best solution in the meantime are dropped.
+ * If the connection fails, the remote connection is stopped.
+ * @param arg The connection (remoteLink*).
+ * @return Returns NULL.
+*/
+static void *runSender(void *arg) {
+  remoteLink *link = arg;
+  myshm *ring = link->ring;
+  unsigned char *payload = malloc(8 * (size_t) ring->max_edges + 1);
+  if (payload == NULL) {
+    printErrAndExit("Allocating sender memory failed");
+  }
+
+  while (__atomic_load_n(&ring->state, __ATOMIC_ACQUIRE) != 1) {
+    unsigned long available = ringAvailable(ring);
+    if (available == 0) {
+      ringWaitConsumer(&ring, 1, WAIT_BLOCK, -1);
+      continue;
+    }
+    unsigned long tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    for (unsigned long i = 0; i < available; i++) {
+      removedEdge *solution = getSlot(ring, tail + i);
+      int count = solution->numOfEdges;
+      if (count == RING_ABANDONED || count >= __atomic_load_n(&ring->best_solution, __ATOMIC_RELAXED)) {
+        continue;
+      }
+      netEncodeEdges(payload, solution->edges, count);
+      if (netSend(link->fd, NET_SOLUTION, count, SOLUTION_EDGES, payload, 8 * count) == -1) {
+        stopRemote(link);
+        break;
+      }
+    }
+    ringRelease(ring, available);
+  }
+
+  free(payload);
+  return NULL;
+}
+
+/**
+ * Receiver thread function
+ * @brief Applies the best solutions broadcast by the supervisor to the private buffer
+ * @details Stops the remote connection once the supervisor closes it or broadcasts 0.
+ * @param arg The connection (remoteLink*).
+ * @return Returns NULL.
+*/
+static void *runReceiver(void *arg) {
+  remoteLink *link = arg;
+  netHeader header;
+  while (netReceive(link->fd, &header, NULL, 0) == 0) {
+    if (header.type != NET_BEST) {
+      continue;
+    }
+    // The receiver is the only writer of best_solution of the private buffer
+    if ((int) header.value < __atomic_load_n(&link->ring->best_solution, __ATOMIC_RELAXED)) {
+      __atomic_store_n(&link->ring->best_solution, (int) header.value, __ATOMIC_RELAXED);
+    }
+    if (header.value == 0) {
+      break;
+    }
+  }
+  stopRemote(link);
+  return NULL;
+}
+
+/**
+ * Connects to a remote supervisor
+ * @brief Joins a job of a supervisor started with -l and sets up the private buffer and the network threads
+ * @details If the supervisor doesn't know the job or any step fails, the program prints an error and exits
+ * @param link The connection
+ * @param address The address of the supervisor as host:port
+ * @param job The job id, or NULL for the default job
+ * @return Returns the private buffer the workers write to.
+*/
+static myshm *connectRemote(remoteLink *link, const char *address, const char *job) {
+  link->fd = netConnect(address);
+  if (netSend(link->fd, NET_HELLO, 0, 0, job, job != NULL ? strlen(job) : 0) == -1) {
+    printErrAndExit("Sending to supervisor failed");
+  }
+  netHeader header;
+  uint32_t geometry[2];
+  if (netReceive(link->fd, &header, geometry, sizeof(geometry)) == -1 || header.type != NET_WELCOME
+      || header.length != sizeof(geometry)) {
+    printErrAndExit("Supervisor rejected the connection");
+  }
+  unsigned long capacity = ntohl(geometry[0]);
+  int max_edges = ntohl(geometry[1]);
+  if (capacity < 2 || capacity > MAX_RING_SLOTS || max_edges < 0 || max_edges > MAX_RING_WIDTH) {
+    printErrAndExit("Supervisor sent an invalid buffer geometry");
+  }
+
+  void *ring;
+  if (posix_memalign(&ring, CACHE_LINE, getSHMSize(capacity, max_edges)) != 0) {
+    printErrAndExit("Allocating the private buffer failed");
+  }
+  link->ring = ring;
+  memset(link->ring, 0, sizeof(myshm));
+  initializeRing(link->ring, capacity, max_edges);
+  link->ring->best_solution = header.value;
+
+  if (pthread_create(&link->sender, NULL, runSender, link) != 0
+      || pthread_create(&link->receiver, NULL, runReceiver, link) != 0) {
+    printErrAndExit("Creating network thread failed");
+  }
+  return link->ring;
+}
+
+/**
+ * Disconnects from a remote supervisor
+ * @brief Stops and joins the network threads, closes the connection and frees the private buffer
+ * @param link The connection
+*/
+static void disconnectRemote(remoteLink *link) {
+  stopRemote(link);
+  shutdown(link->fd, SHUT_RDWR);
+  pthread_join(link->sender, NULL);
+  pthread_join(link->receiver, NULL);
+  close(link->fd);
+  free(link->ring);
+}
+
+/**
+ * Lowers the process best
+ * @brief Atomically sets ctx->process_best to val if val is smaller
+ * @param ctx The generator context
+ * @param val The number of removed edges of a new solution
+ * @return Returns 1 if val is a new process best, 0 if another worker got there first.
+*/
+static int lowerProcessBest(generatorContext *ctx, int val) {
+  int curr = __atomic_load_n(&ctx->process_best, __ATOMIC_RELAXED);
+  while (val < curr) {
+    if (__atomic_compare_exchange_n(&ctx->process_best, &curr, val, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Reports an exhausted exact search
+ * @brief Once the searches of all workers are exhausted, no solution has fewer edges than the smallest of their bounds.
+ * The last worker raises myshm->optimal to it and wakes the supervisor with an abandoned cell (so the wakeup can't be
+ * lost), the supervisor then ends the job as soon as it holds a solution of that size.
+ * @details The pending solutions of the worker must have been written before.
+ * @param ctx The generator context
+ * @param bound The bound of the last search step of the worker
+*/
+static void reportExhausted(generatorContext *ctx, int bound) {
+  int proven = __atomic_load_n(&ctx->proven, __ATOMIC_RELAXED);
+  while (bound < proven && !__atomic_compare_exchange_n(&ctx->proven, &proven, bound, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+  }
+  if (__atomic_add_fetch(&ctx->exhausted, 1, __ATOMIC_ACQ_REL) != ctx->num_workers) {
+    return;
+  }
+  myshm *myshm = ctx->myshm;
+  proven = __atomic_load_n(&ctx->proven, __ATOMIC_RELAXED);
+  int optimal = __atomic_load_n(&myshm->optimal, __ATOMIC_RELAXED);
+  while (proven > optimal && !__atomic_compare_exchange_n(&myshm->optimal, &optimal, proven, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+  }
+  printf("[%s] No solution has fewer than %d edges\n", pgm_name, proven);
+  unsigned long pos;
+  if (ringReserve(myshm, 1, &pos) == 0) {
+    getSlot(myshm, pos)->numOfEdges = RING_ABANDONED;
+    ringPublish(myshm, pos, 1);
+  }
+  ringWakeConsumer(myshm);
+}
+
+/**
+ * Maps removed edges back to the input ids
+ * @brief Undoes the renumbering of reorderGraph, so the supervisor output doesn't depend on it
+ * @param ctx The generator context
+ * @param removed_edges The removed edges, rewritten in place
+ * @param removed_edges_count The number of removed edges
+*/
+static void restoreVertexIds(generatorContext *ctx, edge removed_edges[], int removed_edges_count) {
+  const int *old_id = ctx->graph.old_id;
+  if (old_id == NULL) {
+    return;
+  }
+  for (int j = 0; j < removed_edges_count; j++) {
+    removed_edges[j].source = old_id[removed_edges[j].source];
+    removed_edges[j].destination = old_id[removed_edges[j].destination];
+  }
+}
+
+/**
+ * Writes a solution into a cell
+ * @brief Encodes the current coloring of the search into the payload of slot
+ * @details Without a shared graph the removed edges are written as pairs of input ids. Otherwise the edge indices are
+ * encoded if they are smaller than the packed coloring, which is used if not. Every index takes at least a byte, so the
+ * indices are only listed if cost is below ctx->index_limit.
+ * @param ctx The generator context
+ * @param search The search state
+ * @param cost The number of conflicting edges of the current coloring (below bound)
+ * @param bound The cost to undercut
+ * @param slot The cell
+ * @param edge_ids Scratch space for ctx->index_limit indices
+ * @return Returns 1 if the solution was written, 0 if it doesn't fit into the cell.
+*/
+static int writeSolution(generatorContext *ctx, const searchState *search, int cost, int bound, removedEdge *slot, int edge_ids[]) {
+  if (!ctx->compact) {
+    if (!writeSearchSolution(search, bound - 1, slot->edges, &slot->numOfEdges)) {
+      return 0;
+    }
+    restoreVertexIds(ctx, slot->edges, slot->numOfEdges);
+    slot->format = SOLUTION_EDGES;
+    slot->size = slot->numOfEdges * sizeof(edge);
+    return 1;
+  }
+
+  int count;
+  if ((size_t) cost < ctx->index_limit
+      && listSearchConflicts(search, cost, edge_ids, &count)
+      && encodeIndices(slot, edge_ids, count, ctx->index_limit)) {
+    slot->numOfEdges = count;
+    return 1;
+  }
+  if (ctx->coloring_bytes > getPayloadSize(ctx->myshm)) {
+    return 0;
+  }
+  encodeColoring(slot, search->colors, ctx->numOfVertices);
+  slot->numOfEdges = cost;
+  return 1;
+}
+
+/**
+ * Reports the progress of a worker
+ * @brief Counts the time since the last report that was not spent waiting for cells as search time, see reportGenerator
+ * @param ctx The generator context
+ * @param delta The counts since the last report (cleared)
+ * @param elapsed_ns The time since the last report in nanoseconds
+*/
+static void reportWorker(generatorContext *ctx, generatorCounters *delta, unsigned long elapsed_ns) {
+  delta->solve_ns = elapsed_ns > delta->blocked_ns ? elapsed_ns - delta->blocked_ns : 0;
+  reportGenerator(ctx->entry, delta);
+}
+
+/**
+ * Worker thread function
+ * @brief Repeatedly advances the search and writes improvements to the circular buffer
+ * @details Runs until the supervisor sets state to 1, the generator receives SIGINT or SIGTERM or the exact search is exhausted. Only solutions that fit into a cell (see writeSolution)
+ * and strictly improve on the best solution so far are written to the buffer, the supervisor would discard all others.
+ * Improvements are collected while they keep coming step after step and written as one batch of up to ctx->batch
+ * solutions, so a burst of improvements costs a single reservation. The first step without an improvement flushes them.
+ * The batch is reserved when the first improvement is found and the solutions are written straight into its cells,
+ * cells left over (or taken by a solution that lost against another worker) are abandoned.
+ * Every 64 steps the worker polls the assignment in the registry entry and restarts its search with the assigned
+ * strategy and seed if they differ from the ones it runs (see the -portfolio option of the supervisor).
+ * @param arg The worker (worker*).
+ * @return Returns NULL.
+*/
+static void *runWorker(void *arg) {
+  worker *w = arg;
+  generatorContext *ctx = w->ctx;
+  myshm *myshm = ctx->myshm;
+
+  if (w->cpu >= 0) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(w->cpu, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+      fprintf(stderr, "[%s] Couldn't pin worker %d to cpu %d\n", pgm_name, w->id, w->cpu);
+    }
+  }
+
+  // Mapped after pinning, so the pages are local to the worker's core. Nothing is allocated after this
+  arena arena;
+  size_t edge_ids_bytes = getArenaBytes((ctx->index_limit + 1) * sizeof(int));
+  initArena(&arena, edge_ids_bytes + getSearchBytes(&ctx->graph, ctx->pool != NULL));
+  int *edge_ids = arenaAlloc(&arena, (ctx->index_limit + 1) * sizeof(int));
+  searchState search;
+  int running = ASSIGNMENT(ctx->strategy, ctx->seed);
+  initSearch(&search, ctx->strategy, ctx->seed, &ctx->graph, ctx->kernel, &w->rng, w->id, ctx->num_workers, ctx->pool,
+             &arena);
+  unsigned long pos = 0;
+  int num_claimed = 0, num_pending = 0;
+  // Progress not yet reported to the registry, the clock is only read every 64 steps
+  generatorCounters delta = {0};
+  unsigned long last_report = getMonotonicNanos();
+
+  while(__atomic_load_n(&myshm->state, __ATOMIC_ACQUIRE) != 1 && !quit) {
+    int global_best = __atomic_load_n(&myshm->best_solution, __ATOMIC_RELAXED);
+    int local_best = __atomic_load_n(&ctx->process_best, __ATOMIC_RELAXED);
+    int bound = global_best < local_best ? global_best : local_best;
+
+    // The search reports a coloring as soon as it is known to be an improvement
+    int improved = 0, last_count = -1;
+    int cost = searchStep(&search, bound);
+    if (cost < bound) {
+      if (num_claimed == 0) {
+        // The solutions of a batch strictly decrease, so at most bound of them can follow
+        int count = ctx->batch < bound ? ctx->batch : bound;
+        // Nothing was reserved if the claim fails, pos is stale then
+        if (claimBuff(myshm, count, &pos, &delta.blocked_ns) == -1) {
+          break;
+        }
+        num_claimed = count;
+      }
+      // Written straight into the cell
+      removedEdge *slot = getSlot(myshm, pos + num_pending);
+      slot->generator = ctx->pid;
+      if (writeSolution(ctx, &search, cost, bound, slot, edge_ids) && lowerProcessBest(ctx, slot->numOfEdges)) {
+        last_count = slot->numOfEdges;
+        num_pending++;
+        improved = 1;
+        shareSearchColoring(&search, cost);
+      } else {
+        delta.rejected++;
+      }
+    }
+    if (num_claimed > 0 && (num_pending == num_claimed || !improved || last_count == 0)) {
+      writeBuff(myshm, pos, num_pending, num_claimed);
+      delta.submitted += num_pending;
+      num_claimed = num_pending = 0;
+    }
+    if (isSearchExhausted(&search)) {
+      reportExhausted(ctx, bound);
+      break;
+    }
+    if ((++delta.attempts & 63) == 0) {
+      int assigned = ctx->entry != NULL ? __atomic_load_n(&ctx->entry->assigned, __ATOMIC_RELAXED) : NO_ASSIGNMENT;
+      if (assigned != NO_ASSIGNMENT && assigned != running && ASSIGNED_STRATEGY(assigned) < NUM_STRATEGIES
+          && ASSIGNED_SEED(assigned) < NUM_SEEDS) {
+        freeSearch(&search);
+        initSearch(&search, ASSIGNED_STRATEGY(assigned), ASSIGNED_SEED(assigned), &ctx->graph, ctx->kernel, &w->rng,
+                   w->id, ctx->num_workers, ctx->pool, &arena);
+        running = assigned;
+        __atomic_store_n(&ctx->entry->running, running, __ATOMIC_RELAXED);
+      }
+      unsigned long now = getMonotonicNanos();
+      if (now - last_report >= HEARTBEAT_INTERVAL * 1000000UL) {
+        reportWorker(ctx, &delta, now - last_report);
+        last_report = now;
+      }
+    }
+  }
+
+  // Reserved cells block the buffer until they are published
+  if (num_claimed > 0) {
+    writeBuff(myshm, pos, num_pending, num_claimed);
+    delta.submitted += num_pending;
+  }
+  reportWorker(ctx, &delta, getMonotonicNanos() - last_report);
+  freeSearch(&search);
+  freeArena(&arena);
+  return NULL;
+}
+
+/**
+ * Chooses the cores for pinned workers
+ * @brief Distributes the workers round-robin over the cores this process may run on
+ * @param workers The workers
+ * @param num_workers The number of workers
+*/
+static void assignCores(worker workers[], int num_workers) {
+  cpu_set_t allowed;
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) == -1) {
+    printErrAndExit("Couldn't read cpu affinity");
+  }
+  int cpus[CPU_SETSIZE], num_cpus = 0;
+  for (int c = 0; c < CPU_SETSIZE; c++) {
+    if (CPU_ISSET(c, &allowed)) {
+      cpus[num_cpus++] = c;
+    }
+  }
+  for (int i = 0; i < num_workers; i++) {
+    workers[i].cpu = cpus[i % num_cpus];
+  }
+}
+
+/**
+ * Usage function
+ * @brief Prints the synopsis of the generator to stderr and exits
+ * @details global variables: pgm_name
+*/
+static void usage() {
+  (void) fprintf(stderr, "Usage: %s [-t threads] [-pin] [-r edges] [-c host:port] [-j job] [-b batch] [-s random|minconf|tabu|exact] [-seed random|greedy|rgreedy|dsatur] [-elite size] {-f file | EDGE1...}\n", pgm_name);
+  exit(EXIT_FAILURE);
+}
+
+/**
+ * Parse a number argument
+ * @brief Parses arg as a decimal number in the range [min, max]
+ * @details Calls usage() if the argument is not a number or out of range
+ * @param arg The argument string
+ * @param min The smallest accepted value
+ * @param max The largest accepted value
+ * @return Returns the parsed value.
+*/
+static long parseNumber(const char *arg, long min, long max) {
+  char *end;
+  errno = 0;
+  long value = strtol(arg, &end, 10);
+  if (*arg == '\0' || *end != '\0' || errno != 0 || value < min || value > max) {
+    usage();
+  }
+  return value;
 }
 
 /**
@@ -94,6 +612,18 @@ static void initializeSemaphores() {
  * @details Try to keep the main function small and move any functionality that is used more 
  * than  a single time to extra function(s). Note that you should restrict visibility of those
  * extra functions to the smallest required scope (edge1 with static).
+ * -t sets the number of worker threads (default 1), -pin pins each worker to its own core.
+ * -j attaches to the supervisor of the given job instead of the default one, see jobNames.
+ * -c connects to a supervisor on another host started with -l instead of the local one, see net.h. The generator then
+ * needs a graph of its own and sends its solutions as edge pairs.
+ * -b sets the maximum number of solutions a worker writes to the buffer at once (default DEFAULT_BATCH).
+ * -f reads the graph from a file ("-" for stdin) instead of the arguments, see parseGraphFile.
+ * -s selects the search strategy (default random), see search.h. The workers of the exact strategy split its tree,
+ * once all are exhausted the generator reports the proven bound to the supervisor (not to a remote one).
+ * -seed selects the initial coloring of every worker (default dsatur), see seed.h.
+ * -elite sets the number of colorings of the elite pool (default DEFAULT_ELITE, 0 for none), see elite.h. The pool of
+ * a shared graph is shared with the other generators of the job, the first one decides its size.
+ * -r sets the number of edges from which the vertices are renumbered for cache locality (default DEFAULT_REORDER_EDGES).
  * global variables: pgm_name
  * @param argc The argument counter.
  * @param argv The argument vector.
@@ -102,73 +632,189 @@ static void initializeSemaphores() {
 int main(int argc, char **argv) {
 	pgm_name = argv[0];
 
-  printf("[%s] Starting generator...\n", pgm_name);
+  int num_workers = 1, pin = 0, batch = DEFAULT_BATCH, elite = DEFAULT_ELITE;
+  long reorder_edges = DEFAULT_REORDER_EDGES;
+  const char *graph_path = NULL, *job = NULL, *remote = NULL;
+  int strategy = STRATEGY_RANDOM;
+  int seed_type = SEED_DSATUR;
+  static const struct option long_options[] = {
+    {"t", required_argument, NULL, 't'},
+    {"b", required_argument, NULL, 'b'},
+    {"j", required_argument, NULL, 'j'},
+    {"c", required_argument, NULL, 'c'},
+    {"r", required_argument, NULL, 'r'},
+    {"f", required_argument, NULL, 'f'},
+    {"s", required_argument, NULL, 's'},
+    {"seed", required_argument, NULL, 'i'},
+    {"elite", required_argument, NULL, 'e'},
+    {"pin", no_argument, NULL, 'p'},
+    {NULL, 0, NULL, 0}
+  };
+  int c;
+  while ((c = getopt_long_only(argc, argv, "t:b:j:c:r:f:s:", long_options, NULL)) != -1) {
+    switch (c) {
+      case 't':
+        num_workers = parseNumber(optarg, 1, MAX_THREADS);
+        break;
+      case 'j':
+        job = optarg;
+        break;
+      case 'c':
+        remote = optarg;
+        break;
+      case 'b':
+        batch = parseNumber(optarg, 1, MAX_BATCH);
+        break;
+      case 'r':
+        reorder_edges = parseNumber(optarg, 0, LONG_MAX);
+        break;
+      case 'e':
+        elite = parseNumber(optarg, 0, MAX_ELITE);
+        break;
+      case 'p':
+        pin = 1;
+        break;
+      case 'f':
+        graph_path = optarg;
+        break;
+      case 's':
+        if ((strategy = parseStrategy(optarg)) == -1) {
+          usage();
+        }
+        break;
+      case 'i':
+        if ((seed_type = parseSeed(optarg)) == -1) {
+          usage();
+        }
+        break;
+      default:
+        usage();
+    }
+  }
 
-  int i, max = -1;
+  jobNames names;
+  if (initJobNames(&names, job) == -1) {
+    usage();
+  }
 
-  // Seeding the random variable
-  srand (time(NULL));
-  
-  int edge1 = 0;  
-  int edge2 = 0;
-  for (i = 1; i < argc; i++) {
-    if (sscanf(argv[i], "%d-%d", &edge1, &edge2) != 2) {
-      printErrAndExit("Couldn't parse all edges");
-    }
-    if (edge1 > edge2) {
-      max = edge1;
-    } else {
-      max = edge2;
+  printf("[%s] Starting generator...\n", pgm_name);
+
+  edgeList list = {0};
+  if (graph_path != NULL) {
+    if (optind != argc) {
+      usage();
     }
+    parseGraphFile(&list, graph_path);
+  } else {
+    parseEdgeArgs(&list, argv + optind, argc - optind);
   }
+  // Without a graph the generator works on the graph shared by the supervisor or another generator
+  int attach_only = graph_path == NULL && optind == argc;
 
-  int numOfVertices = max + 1, numOfEdges = argc - 1;
-  int color_indices[numOfVertices];
-  edge edges[numOfEdges];
-
-  for (i = 1; i < argc; i++) {
-    if (sscanf(argv[i], "%d-%d", &edge1, &edge2) != 2) {
-      printErrAndExit("Couldn't parse all edges");
+  remoteLink link;
+  myshm *myshm;
+  if (remote != NULL) {
+    // A remote supervisor can't share a graph segment with this host
+    if (attach_only) {
+      usage();
     }
-    edges[i - 1].source = edge1;
-    edges[i - 1].destination = edge2;
+    myshm = connectRemote(&link, remote, job);
+  } else {
+    int shmfd = openSHMFileDescriptor(&names);
+    myshm = createMappedSHMObject(shmfd);
+    initializeSemaphores(&names);
   }
 
-  randomizeColors(numOfVertices, color_indices);
+	/* DONE SETTING UP SHARED MEMORY OBJECT AND SEMAPHORES */
 
-  // Worst case, all edges are removed so we allocate numOfEdges
-  edge removed_edges[numOfEdges];
-  int removed_edges_count = 0;
-  solveColorProblem(color_indices, removed_edges, &removed_edges_count, edges, numOfEdges);
+  // The geometry is valid once USED_SEM exists
+  int max_edges = myshm->max_edges;
 
-  int shmfd = openSHMFileDescriptor();
-	myshm *myshm = createMappedSHMObject(shmfd);
-  initializeSemaphores();
+  generatorContext ctx = {
+    .strategy = strategy,
+    .seed = seed_type,
+    .myshm = myshm,
+    .max_edges = max_edges,
+    .pid = getpid(),
+    .num_workers = num_workers,
+    .proven = INT_MAX,
+    .process_best = max_edges + 1,
+    // A batch has to fit into the buffer
+    .batch = (unsigned long) batch < myshm->capacity ? batch : (int) myshm->capacity
+  };
+  if (remote != NULL) {
+    buildGraph(&ctx.graph, &list, reorder_edges, 1);
+    freeEdgeList(&list);
+  } else {
+    // Only after attaching to the supervisor, which removes stale shared graphs on startup
+    ctx.compact = loadGraph(&ctx.graph, attach_only ? NULL : &list, reorder_edges, names.graph);
+  }
+  ctx.numOfVertices = ctx.graph.store.numOfVertices;
+  ctx.kernel = selectConflictKernel(&ctx.graph.store);
+  if (elite > 0) {
+    // The workers of a private graph, or of one whose elite object belongs to another graph, still share a pool
+    ctx.pool = ctx.compact ? openElitePool(names.elite, elite, &ctx.graph) : NULL;
+    if (ctx.pool == NULL) {
+      ctx.pool = openElitePool(NULL, elite, &ctx.graph);
+    }
+  }
+  if (ctx.compact) {
+    size_t payload = getPayloadSize(myshm);
+    ctx.coloring_bytes = getColoringBytes(ctx.numOfVertices);
+    ctx.index_limit = ctx.coloring_bytes < payload ? ctx.coloring_bytes : payload;
+    // Any solution fits as a coloring, otherwise every edge index takes at least a byte
+    ctx.process_best = ctx.coloring_bytes <= payload ? INT_MAX : (int) payload + 1;
+  }
 
-	/* DONE SETTING UP SHARED MEMORY OBJECT AND SEMAPHORES */
+  // Registered once the graph is loaded, so the heartbeat starts with the search
+  if (remote == NULL) {
+    ctx.entry = registerGenerator(myshm, getpid(), ASSIGNMENT(strategy, seed_type));
+  }
+  // Only from here on, a generator still waiting for a shared graph terminates right away
+  struct sigaction sa = {
+    .sa_handler = handle_signal
+  };
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
 
-  sem_post(mutex_sem);
-  myshm->generator_count += 1;
-  sem_wait(mutex_sem);
-  
-  // Only write to the buffer, if the removed edges are less than MAX_SOLUTION_EDGES
-  // Big solutions are not wanted
-  while(myshm->state != 1) {
-    if (removed_edges_count <= MAX_SOLUTION_EDGES) {
-      sem_post(mutex_sem);
-      writeBuff(removed_edges_count, removed_edges, myshm->removed_edges);
-      sem_wait(mutex_sem);
+  worker *workers = calloc(num_workers, sizeof(worker));
+  if (workers == NULL) {
+    printErrAndExit("Allocating workers failed");
+  }
+  int i;
+  // Seeding, the pid keeps generators started in the same second apart
+  uint64_t seed = ((uint64_t) time(NULL) << 32) ^ (uint64_t) getpid();
+  for (i = 0; i < num_workers; i++) {
+    workers[i].id = i;
+    workers[i].cpu = -1;
+    workers[i].ctx = &ctx;
+    seedRng(&workers[i].rng, seed + i);
+  }
+  if (pin) {
+    assignCores(workers, num_workers);
+  }
+  for (i = 0; i < num_workers; i++) {
+    if (pthread_create(&workers[i].thread, NULL, runWorker, &workers[i]) != 0) {
+      printErrAndExit("Creating worker thread failed");
     }
-    randomizeColors(numOfVertices, color_indices);
-    removed_edges_count = 0;
-    solveColorProblem(color_indices, removed_edges, &removed_edges_count, edges, numOfEdges);
   }
+  for (i = 0; i < num_workers; i++) {
+    pthread_join(workers[i].thread, NULL);
+  }
+  free(workers);
+  closeElitePool(ctx.pool);
+  freeGraph(&ctx.graph);
 
   /* CLOSE SEMAPHORES AND UNMAP */
   printf("[%s] Terminating...\n", pgm_name);
 
-  unmapSHM(myshm);
-  closeSemaphores(used_sem, free_sem, mutex_sem);
+  unregisterGenerator(ctx.entry, getpid());
+  if (remote != NULL) {
+    disconnectRemote(&link);
+  } else {
+    unmapSHM(myshm);
+    closeSemaphores(used_sem);
+  }
 
 	return EXIT_SUCCESS;
 } 
\ No newline at end of file
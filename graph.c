@@ -0,0 +1,860 @@
+/**
+ * @file graph.c
+ * @author Giancarlo Buenaflor <e51837398@tuwien.ac.at>
+ * @date 18.11.2020
+ * 
+ * @brief Implementation of the graph module.
+ *
+ **/
+
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include "graph.h"
+
+/** Size of the chunks in which non-regular inputs are read */
+#define READ_CHUNK (1 << 20)
+
+/** Number of milliseconds a generator waits for another process to finish publishing the shared graph */
+#define GRAPH_READY_TIMEOUT_MS (10000)
+
+/** Represents a vertex together with its degree, used to sort vertices by degree */
+typedef struct degreeEntry {
+  int degree;
+  int vertex;
+} degreeEntry;
+
+/**
+ * Compares two vertices by degree
+ * @brief Ties are broken by the vertex id, so the order is deterministic
+ * @param a The first degreeEntry
+ * @param b The second degreeEntry
+ * @return Returns a negative, zero or positive value like strcmp.
+*/
+static int compareDegree(const void *a, const void *b) {
+  const degreeEntry *x = a, *y = b;
+  if (x->degree != y->degree) {
+    return x->degree < y->degree ? -1 : 1;
+  }
+  return (x->vertex > y->vertex) - (x->vertex < y->vertex);
+}
+
+/**
+ * Compares two edges by (source, destination)
+ * @param a The first edge
+ * @param b The second edge
+ * @return Returns a negative, zero or positive value like strcmp.
+*/
+static int compareEdge(const void *a, const void *b) {
+  const edge *x = a, *y = b;
+  if (x->source != y->source) {
+    return x->source < y->source ? -1 : 1;
+  }
+  return (x->destination > y->destination) - (x->destination < y->destination);
+}
+
+/**
+ * Allocates memory or exits
+ * @param size The number of bytes
+ * @return Returns the allocated memory.
+*/
+static void *allocOrExit(size_t size) {
+  void *p = malloc(size > 0 ? size : 1);
+  if (p == NULL) {
+    printErrAndExit("Allocating graph memory failed");
+  }
+  return p;
+}
+
+void appendEdge(edgeList *list, int source, int destination) {
+  if (list->numOfEdges == list->capacity) {
+    if (list->capacity > INT_MAX / 2) {
+      printErrAndExit("Too many edges");
+    }
+    int capacity = list->capacity > 0 ? 2 * list->capacity : 1024;
+    edge *edges = realloc(list->edges, (size_t) capacity * sizeof(edge));
+    if (edges == NULL) {
+      printErrAndExit("Allocating graph memory failed");
+    }
+    list->edges = edges;
+    list->capacity = capacity;
+  }
+  list->edges[list->numOfEdges].source = source;
+  list->edges[list->numOfEdges].destination = destination;
+  list->numOfEdges++;
+  if (source >= list->numOfVertices) {
+    list->numOfVertices = source + 1;
+  }
+  if (destination >= list->numOfVertices) {
+    list->numOfVertices = destination + 1;
+  }
+}
+
+void freeEdgeList(edgeList *list) {
+  free(list->edges);
+  list->edges = NULL;
+  list->numOfEdges = list->capacity = 0;
+}
+
+/**
+ * Parses a nonnegative decimal number
+ * @brief Advances *p over the digits
+ * @param p The current position (pointer, will be advanced)
+ * @param end The end of the input
+ * @param value The parsed value (pointer)
+ * @return Returns 0 on success, -1 if there are no digits or the number doesn't fit into an int (minus one, so id + 1 can't overflow).
+*/
+static int parseNumber(const char **p, const char *end, int *value) {
+  const char *q = *p;
+  long v = 0;
+  if (q == end || !isdigit((unsigned char) *q)) {
+    return -1;
+  }
+  while (q < end && isdigit((unsigned char) *q)) {
+    v = 10 * v + (*q++ - '0');
+    if (v >= INT_MAX) {
+      return -1;
+    }
+  }
+  *p = q;
+  *value = v;
+  return 0;
+}
+
+/**
+ * Skips blanks
+ * @param p The current position
+ * @param end The end of the input
+ * @return Returns the first position that is not a space or tab.
+*/
+static const char *skipBlanks(const char *p, const char *end) {
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+    p++;
+  }
+  return p;
+}
+
+/**
+ * Prints a parse error and exits
+ * @param line The line number of the error
+*/
+static void parseError(long line) {
+  char msg[64];
+  snprintf(msg, sizeof(msg), "Couldn't parse graph in line %ld", line);
+  printErrAndExit(msg);
+}
+
+/**
+ * Parses one line in a-b or plain edge list syntax
+ * @param list The edge list
+ * @param p The start of the line
+ * @param end The end of the line
+ * @param line The line number, used for errors
+*/
+static void parseEdgeLine(edgeList *list, const char *p, const char *end, long line) {
+  int u, v;
+  while ((p = skipBlanks(p, end)) < end) {
+    if (parseNumber(&p, end, &u) == -1) {
+      parseError(line);
+    }
+    if (p < end && *p == '-') {
+      p++;
+      if (parseNumber(&p, end, &v) == -1) {
+        parseError(line);
+      }
+      appendEdge(list, u, v);
+      continue;
+    }
+    // Plain edge list, everything after the second column is ignored
+    p = skipBlanks(p, end);
+    if (parseNumber(&p, end, &v) == -1) {
+      parseError(line);
+    }
+    appendEdge(list, u, v);
+    return;
+  }
+}
+
+/**
+ * Parses a DIMACS problem line
+ * @brief Only the vertex count is used, the edge count reserves memory
+ * @param list The edge list
+ * @param p The position after the leading p
+ * @param end The end of the line
+ * @param line The line number, used for errors
+*/
+static void parseProblemLine(edgeList *list, const char *p, const char *end, long line) {
+  p = skipBlanks(p, end);
+  while (p < end && isalpha((unsigned char) *p)) {
+    p++;
+  }
+  int vertices, edges;
+  p = skipBlanks(p, end);
+  if (parseNumber(&p, end, &vertices) == -1) {
+    parseError(line);
+  }
+  p = skipBlanks(p, end);
+  if (parseNumber(&p, end, &edges) == -1) {
+    parseError(line);
+  }
+  if (vertices > list->numOfVertices) {
+    list->numOfVertices = vertices;
+  }
+  if (edges > list->capacity) {
+    edge *reserved = realloc(list->edges, edges * sizeof(edge));
+    if (reserved == NULL) {
+      printErrAndExit("Allocating graph memory failed");
+    }
+    list->edges = reserved;
+    list->capacity = edges;
+  }
+}
+
+/**
+ * Parses a whole input buffer
+ * @param list The edge list
+ * @param p The start of the input
+ * @param end The end of the input
+*/
+static void parseGraphBuffer(edgeList *list, const char *p, const char *end) {
+  long line = 0;
+  while (p < end) {
+    const char *eol = memchr(p, '\n', end - p);
+    if (eol == NULL) {
+      eol = end;
+    }
+    line++;
+    const char *q = skipBlanks(p, eol);
+    if (q < eol) {
+      switch (*q) {
+        case 'c':
+        case '#':
+        case '%':
+          break;
+        case 'p':
+          parseProblemLine(list, q + 1, eol, line);
+          break;
+        case 'e': {
+          int u, v;
+          q = skipBlanks(q + 1, eol);
+          if (parseNumber(&q, eol, &u) == -1 || u == 0) {
+            parseError(line);
+          }
+          q = skipBlanks(q, eol);
+          if (parseNumber(&q, eol, &v) == -1 || v == 0) {
+            parseError(line);
+          }
+          appendEdge(list, u - 1, v - 1);
+          break;
+        }
+        default:
+          parseEdgeLine(list, q, eol, line);
+      }
+    }
+    p = eol + 1;
+  }
+}
+
+void parseEdgeArgs(edgeList *list, char **args, int num_args) {
+  for (int i = 0; i < num_args; i++) {
+    const char *p = args[i], *end = p + strlen(p);
+    int u, v;
+    if (parseNumber(&p, end, &u) == -1 || p == end || *p++ != '-' || parseNumber(&p, end, &v) == -1 || p != end) {
+      printErrAndExit("Couldn't parse all edges");
+    }
+    appendEdge(list, u, v);
+  }
+}
+
+void parseGraphFile(edgeList *list, const char *path) {
+  int fd = strcmp(path, "-") == 0 ? STDIN_FILENO : open(path, O_RDONLY);
+  if (fd == -1) {
+    printErrAndExit("Couldn't open graph file");
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      printErrAndExit("Mapping graph file failed");
+    }
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+    parseGraphBuffer(list, data, (const char *) data + st.st_size);
+    munmap(data, st.st_size);
+  } else {
+    size_t size = 0, capacity = READ_CHUNK;
+    char *data = allocOrExit(capacity);
+    for (;;) {
+      if (capacity - size < READ_CHUNK) {
+        capacity *= 2;
+        char *grown = realloc(data, capacity);
+        if (grown == NULL) {
+          printErrAndExit("Allocating graph memory failed");
+        }
+        data = grown;
+      }
+      ssize_t n = read(fd, data + size, capacity - size);
+      if (n == -1 && errno == EINTR) {
+        continue;
+      }
+      if (n == -1) {
+        printErrAndExit("Reading graph file failed");
+      }
+      if (n == 0) {
+        break;
+      }
+      size += n;
+    }
+    parseGraphBuffer(list, data, data + size);
+    free(data);
+  }
+
+  if (fd != STDIN_FILENO) {
+    close(fd);
+  }
+}
+
+void buildAdjacency(adjacency *adj, const edge edges[], int numOfEdges, int numOfVertices) {
+  adj->numOfVertices = numOfVertices;
+  adj->offsets = calloc(numOfVertices + 1, sizeof(int));
+  if (adj->offsets == NULL) {
+    printErrAndExit("Allocating graph memory failed");
+  }
+  for (int e = 0; e < numOfEdges; e++) {
+    if (edges[e].source != edges[e].destination) {
+      adj->offsets[edges[e].source + 1]++;
+      adj->offsets[edges[e].destination + 1]++;
+    }
+  }
+  for (int v = 0; v < numOfVertices; v++) {
+    adj->offsets[v + 1] += adj->offsets[v];
+  }
+
+  adj->neighbors = allocOrExit(adj->offsets[numOfVertices] * sizeof(int));
+  adj->edge_ids = allocOrExit(adj->offsets[numOfVertices] * sizeof(int));
+  int *fill = allocOrExit(numOfVertices * sizeof(int));
+  memcpy(fill, adj->offsets, numOfVertices * sizeof(int));
+  for (int e = 0; e < numOfEdges; e++) {
+    int u = edges[e].source, v = edges[e].destination;
+    if (u != v) {
+      adj->edge_ids[fill[u]] = e;
+      adj->neighbors[fill[u]++] = v;
+      adj->edge_ids[fill[v]] = e;
+      adj->neighbors[fill[v]++] = u;
+    }
+  }
+  free(fill);
+}
+
+void freeAdjacency(adjacency *adj) {
+  free(adj->offsets);
+  free(adj->neighbors);
+  free(adj->edge_ids);
+  adj->offsets = NULL;
+  adj->neighbors = NULL;
+  adj->edge_ids = NULL;
+}
+
+int *reorderGraph(edge edges[], int numOfEdges, int numOfVertices) {
+  adjacency adj;
+  buildAdjacency(&adj, edges, numOfEdges, numOfVertices);
+
+  // Start vertices are tried by ascending degree
+  degreeEntry *by_degree = allocOrExit(numOfVertices * sizeof(degreeEntry));
+  for (int v = 0; v < numOfVertices; v++) {
+    by_degree[v].degree = getDegree(&adj, v);
+    by_degree[v].vertex = v;
+  }
+  qsort(by_degree, numOfVertices, sizeof(degreeEntry), compareDegree);
+
+  int *order = allocOrExit(numOfVertices * sizeof(int));
+  char *visited = calloc(numOfVertices > 0 ? numOfVertices : 1, 1);
+  degreeEntry *frontier = allocOrExit(numOfVertices * sizeof(degreeEntry));
+  if (visited == NULL) {
+    printErrAndExit("Allocating graph memory failed");
+  }
+
+  // order doubles as the BFS queue, head is the next vertex whose neighbours are expanded
+  int tail = 0;
+  for (int i = 0; i < numOfVertices; i++) {
+    int start = by_degree[i].vertex;
+    if (visited[start]) {
+      continue;
+    }
+    visited[start] = 1;
+    int head = tail;
+    order[tail++] = start;
+    while (head < tail) {
+      int u = order[head++], n = 0;
+      for (int k = adj.offsets[u]; k < adj.offsets[u + 1]; k++) {
+        int v = adj.neighbors[k];
+        if (!visited[v]) {
+          visited[v] = 1;
+          frontier[n].degree = getDegree(&adj, v);
+          frontier[n].vertex = v;
+          n++;
+        }
+      }
+      qsort(frontier, n, sizeof(degreeEntry), compareDegree);
+      for (int k = 0; k < n; k++) {
+        order[tail++] = frontier[k].vertex;
+      }
+    }
+  }
+
+  // Reverse Cuthill-McKee, old_id[new] = old and new_id[old] = new
+  int *old_id = allocOrExit(numOfVertices * sizeof(int));
+  int *new_id = allocOrExit(numOfVertices * sizeof(int));
+  for (int i = 0; i < numOfVertices; i++) {
+    old_id[i] = order[numOfVertices - 1 - i];
+    new_id[old_id[i]] = i;
+  }
+  for (int e = 0; e < numOfEdges; e++) {
+    edges[e].source = new_id[edges[e].source];
+    edges[e].destination = new_id[edges[e].destination];
+  }
+  qsort(edges, numOfEdges, sizeof(edge), compareEdge);
+
+  free(new_id);
+  free(frontier);
+  free(visited);
+  free(order);
+  free(by_degree);
+  freeAdjacency(&adj);
+  return old_id;
+}
+
+/**
+ * Finds the root of a vertex in a union-find forest
+ * @brief Halves the path on the way
+ * @param parent The parent of every vertex (roots point to themselves)
+ * @param v The vertex
+ * @return Returns the root of v.
+*/
+static int findRoot(int parent[], int v) {
+  while (parent[v] != v) {
+    parent[v] = parent[parent[v]];
+    v = parent[v];
+  }
+  return v;
+}
+
+int *reduceGraph(edgeList *list) {
+  int n = list->numOfVertices;
+  edge *edges = list->edges;
+  adjacency adj;
+  buildAdjacency(&adj, edges, list->numOfEdges, n);
+
+  // Peeling, a vertex is pushed once its remaining degree drops below 3
+  int *degree = allocOrExit(n * sizeof(int));
+  int *stack = allocOrExit(n * sizeof(int));
+  char *removed = calloc(n > 0 ? n : 1, 1);
+  if (removed == NULL) {
+    printErrAndExit("Allocating graph memory failed");
+  }
+  int top = 0;
+  for (int v = 0; v < n; v++) {
+    degree[v] = getDegree(&adj, v);
+    if (degree[v] < 3) {
+      removed[v] = 1;
+      stack[top++] = v;
+    }
+  }
+  while (top > 0) {
+    int v = stack[--top];
+    for (int k = adj.offsets[v]; k < adj.offsets[v + 1]; k++) {
+      int u = adj.neighbors[k];
+      if (!removed[u] && --degree[u] < 3) {
+        removed[u] = 1;
+        stack[top++] = u;
+      }
+    }
+  }
+  freeAdjacency(&adj);
+
+  // The kept edges join the remaining vertices into components
+  int *parent = stack;
+  for (int v = 0; v < n; v++) {
+    parent[v] = v;
+  }
+  int kept = 0;
+  for (int e = 0; e < list->numOfEdges; e++) {
+    int u = edges[e].source, v = edges[e].destination;
+    if (u == v || (!removed[u] && !removed[v])) {
+      edges[kept++] = edges[e];
+      parent[findRoot(parent, u)] = findRoot(parent, v);
+    }
+  }
+  list->numOfEdges = kept;
+
+  // Counting sort of the vertices with edges by component, components ordered by their first vertex
+  int *component = degree;
+  for (int v = 0; v < n; v++) {
+    component[v] = -1;
+  }
+  for (int e = 0; e < kept; e++) {
+    removed[edges[e].source] = removed[edges[e].destination] = 2;
+  }
+  int num_components = 0;
+  for (int v = 0; v < n; v++) {
+    if (removed[v] == 2) {
+      int root = findRoot(parent, v);
+      if (component[root] == -1) {
+        component[root] = num_components++;
+      }
+    }
+  }
+  int *first = allocOrExit((num_components + 1) * sizeof(int));
+  memset(first, 0, (num_components + 1) * sizeof(int));
+  for (int v = 0; v < n; v++) {
+    if (removed[v] == 2) {
+      first[component[findRoot(parent, v)] + 1]++;
+    }
+  }
+  for (int k = 0; k < num_components; k++) {
+    first[k + 1] += first[k];
+  }
+  int new_n = first[num_components];
+  int *old_id = allocOrExit(new_n * sizeof(int));
+  int *new_id = stack;
+  int identity = new_n == n;
+  for (int v = 0; v < n; v++) {
+    if (removed[v] == 2) {
+      int id = first[component[findRoot(parent, v)]]++;
+      old_id[id] = v;
+      identity &= id == v;
+    }
+  }
+  // parent is no longer needed, it becomes new_id
+  for (int i = 0; i < new_n; i++) {
+    new_id[old_id[i]] = i;
+  }
+  for (int e = 0; e < kept; e++) {
+    edges[e].source = new_id[edges[e].source];
+    edges[e].destination = new_id[edges[e].destination];
+  }
+  qsort(edges, kept, sizeof(edge), compareEdge);
+  list->numOfVertices = new_n;
+
+  free(first);
+  free(removed);
+  free(stack);
+  free(degree);
+  if (identity) {
+    free(old_id);
+    return NULL;
+  }
+  return old_id;
+}
+
+/**
+ * Finds the components of a graph
+ * @brief Numbers the components in the order of their first vertex and sets their vertex and edge ranges
+ * @details Ranges need consecutive vertices in every component and edges sorted by source, as left by reduceGraph and
+ * reorderGraph. Any other graph is treated as a single component. If allocating fails, the function prints an error and exits
+ * @param g The graph (store and adjacency built), the components are set
+ * @param edges The edges of the store
+*/
+static void findComponents(graph *g, const edge edges[]) {
+  int n = g->store.numOfVertices;
+  char *visited = calloc(n > 0 ? n : 1, 1);
+  int *queue = allocOrExit(n * sizeof(int));
+  if (visited == NULL) {
+    printErrAndExit("Allocating graph memory failed");
+  }
+  g->components = allocOrExit((n + 1) * sizeof(int));
+  int num_components = 0, consecutive = 1;
+  for (int e = 1; e < g->store.numOfEdges; e++) {
+    consecutive &= edges[e - 1].source <= edges[e].source;
+  }
+  for (int v = 0; v < n && consecutive; v++) {
+    if (visited[v]) {
+      continue;
+    }
+    g->components[num_components++] = v;
+    int head = 0, tail = 0;
+    visited[v] = 1;
+    queue[tail++] = v;
+    while (head < tail) {
+      int u = queue[head++];
+      // Vertices before v are visited already, so the component is consecutive if it stays below v + its size
+      for (int k = g->adj.offsets[u]; k < g->adj.offsets[u + 1]; k++) {
+        int w = g->adj.neighbors[k];
+        if (!visited[w]) {
+          visited[w] = 1;
+          queue[tail++] = w;
+        }
+      }
+    }
+    for (int i = 0; i < tail; i++) {
+      consecutive &= queue[i] < v + tail;
+    }
+  }
+  if (!consecutive) {
+    g->components[0] = 0;
+    num_components = n > 0 ? 1 : 0;
+  }
+  g->components[num_components] = n;
+  g->numOfComponents = num_components;
+
+  g->component_edges = allocOrExit((num_components + 1) * sizeof(int));
+  for (int k = 0, e = 0; k <= num_components; k++) {
+    while (e < g->store.numOfEdges && (k == num_components || edges[e].source < g->components[k])) {
+      e++;
+    }
+    g->component_edges[k] = e;
+  }
+  free(queue);
+  free(visited);
+}
+
+void buildEdgeStore(edgeStore *store, edge edges[], int numOfEdges, int numOfVertices) {
+  store->numOfEdges = numOfEdges;
+  store->numOfVertices = numOfVertices;
+  store->id_bytes = numOfVertices <= UINT8_MAX + 1 ? 1 : numOfVertices <= UINT16_MAX + 1 ? 2 : 4;
+  store->src = allocOrExit(numOfEdges * store->id_bytes);
+  store->dst = allocOrExit(numOfEdges * store->id_bytes);
+
+  for (int e = 0; e < numOfEdges; e++) {
+    if (store->id_bytes == 1) {
+      ((uint8_t *) store->src)[e] = edges[e].source;
+      ((uint8_t *) store->dst)[e] = edges[e].destination;
+    } else if (store->id_bytes == 2) {
+      ((uint16_t *) store->src)[e] = edges[e].source;
+      ((uint16_t *) store->dst)[e] = edges[e].destination;
+    } else {
+      ((uint32_t *) store->src)[e] = edges[e].source;
+      ((uint32_t *) store->dst)[e] = edges[e].destination;
+    }
+  }
+}
+
+void freeEdgeStore(edgeStore *store) {
+  free(store->src);
+  free(store->dst);
+  store->src = NULL;
+  store->dst = NULL;
+}
+
+uint64_t hashEdgeList(const edgeList *list) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  const unsigned char *p = (const unsigned char *) &list->numOfVertices;
+  for (size_t i = 0; i < sizeof(int); i++) {
+    hash = (hash ^ p[i]) * 0x100000001b3ULL;
+  }
+  p = (const unsigned char *) list->edges;
+  for (size_t i = 0; i < (size_t) list->numOfEdges * sizeof(edge); i++) {
+    hash = (hash ^ p[i]) * 0x100000001b3ULL;
+  }
+  return hash != 0 ? hash : 1;
+}
+
+void buildGraph(graph *g, edgeList *list, long reorder_edges, int reduce) {
+  g->old_id = NULL;
+  g->mapping = NULL;
+  g->mapping_size = 0;
+  if (reduce) {
+    g->old_id = reduceGraph(list);
+  }
+  if (list->numOfEdges >= reorder_edges) {
+    int *old_id = reorderGraph(list->edges, list->numOfEdges, list->numOfVertices);
+    if (g->old_id != NULL) {
+      for (int v = 0; v < list->numOfVertices; v++) {
+        old_id[v] = g->old_id[old_id[v]];
+      }
+      free(g->old_id);
+    }
+    g->old_id = old_id;
+  }
+  buildEdgeStore(&g->store, list->edges, list->numOfEdges, list->numOfVertices);
+  buildAdjacency(&g->adj, list->edges, list->numOfEdges, list->numOfVertices);
+  findComponents(g, list->edges);
+}
+
+/**
+ * Rounds a byte offset up to a cache line
+ * @param offset The offset
+ * @return Returns the aligned offset.
+*/
+static size_t alignOffset(size_t offset) {
+  return (offset + CACHE_LINE - 1) & ~((size_t) CACHE_LINE - 1);
+}
+
+int publishGraph(const graph *g, uint64_t hash, const char *name) {
+  int shmfd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (shmfd == -1) {
+    if (errno == EEXIST) {
+      return -1;
+    }
+    printErrAndExit("SHM_GRAPH_NAME failed creation");
+  }
+
+  const edgeStore *store = &g->store;
+  size_t edge_bytes = (size_t) store->numOfEdges * store->id_bytes;
+  size_t vertex_bytes = (size_t) store->numOfVertices * sizeof(int);
+  size_t neighbor_bytes = (size_t) g->adj.offsets[store->numOfVertices] * sizeof(int);
+  graphHeader layout = {
+    .numOfVertices = store->numOfVertices,
+    .numOfEdges = store->numOfEdges,
+    .id_bytes = store->id_bytes,
+    .numOfComponents = g->numOfComponents,
+    .hash = hash
+  };
+  size_t component_bytes = (size_t) (g->numOfComponents + 1) * sizeof(int);
+  layout.src_offset = alignOffset(sizeof(graphHeader));
+  layout.dst_offset = alignOffset(layout.src_offset + edge_bytes);
+  layout.old_id_offset = g->old_id != NULL ? alignOffset(layout.dst_offset + edge_bytes) : 0;
+  layout.offsets_offset = alignOffset((g->old_id != NULL ? layout.old_id_offset + vertex_bytes : layout.dst_offset + edge_bytes));
+  layout.neighbors_offset = alignOffset(layout.offsets_offset + vertex_bytes + sizeof(int));
+  layout.edge_ids_offset = alignOffset(layout.neighbors_offset + neighbor_bytes);
+  layout.components_offset = alignOffset(layout.edge_ids_offset + neighbor_bytes);
+  layout.component_edges_offset = alignOffset(layout.components_offset + component_bytes);
+  layout.size = layout.component_edges_offset + component_bytes;
+
+  if (ftruncate(shmfd, layout.size) < 0) {
+    printErrAndExit("Truncate SHM graph failed");
+  }
+  unsigned char *base = mmap(NULL, layout.size, PROT_READ | PROT_WRITE, MAP_SHARED, shmfd, 0);
+  if (base == MAP_FAILED) {
+    printErrAndExit("Mapping SHM graph failed");
+  }
+  close(shmfd);
+#ifdef MADV_HUGEPAGE
+  // Before the pages are touched, so the kernel can back them with hugepages (shmem_enabled=advise)
+  madvise(base, layout.size, MADV_HUGEPAGE);
+#endif
+
+  memcpy(base, &layout, sizeof(graphHeader));
+  memcpy(base + layout.src_offset, store->src, edge_bytes);
+  memcpy(base + layout.dst_offset, store->dst, edge_bytes);
+  if (g->old_id != NULL) {
+    memcpy(base + layout.old_id_offset, g->old_id, vertex_bytes);
+  }
+  memcpy(base + layout.offsets_offset, g->adj.offsets, vertex_bytes + sizeof(int));
+  memcpy(base + layout.neighbors_offset, g->adj.neighbors, neighbor_bytes);
+  memcpy(base + layout.edge_ids_offset, g->adj.edge_ids, neighbor_bytes);
+  memcpy(base + layout.components_offset, g->components, component_bytes);
+  memcpy(base + layout.component_edges_offset, g->component_edges, component_bytes);
+  __atomic_store_n(&((graphHeader *) base)->ready, 1, __ATOMIC_RELEASE);
+
+  munmap(base, layout.size);
+  return 0;
+}
+
+/**
+ * Maps the shared graph
+ * @brief Opens the shared graph object read-only and waits until it is completely published
+ * @details Hugepages are requested with madvise where the kernel supports them for shared memory
+ * @param g The graph, set up to point into the mapping
+ * @param name The name of the shared graph object
+ * @param hash The expected hash, or 0 to accept any graph
+ * @param wait 1 if a missing segment should be waited for, 0 if it should fail immediately
+ * @return Returns 0 on success, -1 if the segment doesn't exist (in time) or holds a different graph.
+*/
+static int attachGraph(graph *g, const char *name, uint64_t hash, int wait) {
+  int shmfd;
+  struct stat st;
+  for (int waited = 0; ; waited++) {
+    shmfd = shm_open(name, O_RDONLY, 0600);
+    if (shmfd == -1) {
+      if (errno != ENOENT) {
+        printErrAndExit("Couldn't open SHM graph");
+      }
+      if (!wait || waited >= GRAPH_READY_TIMEOUT_MS) {
+        return -1;
+      }
+    } else {
+      if (fstat(shmfd, &st) == -1) {
+        printErrAndExit("Stat SHM graph failed");
+      }
+      // The publisher may not have truncated the segment yet
+      if ((size_t) st.st_size >= sizeof(graphHeader)) {
+        break;
+      }
+      close(shmfd);
+      if (waited >= GRAPH_READY_TIMEOUT_MS) {
+        return -1;
+      }
+    }
+    usleep(1000);
+  }
+
+  unsigned char *base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, shmfd, 0);
+  if (base == MAP_FAILED) {
+    printErrAndExit("Mapping SHM graph failed");
+  }
+  close(shmfd);
+
+  const graphHeader *header = (const graphHeader *) base;
+  for (int waited = 0; __atomic_load_n(&header->ready, __ATOMIC_ACQUIRE) == 0; waited++) {
+    if (waited >= GRAPH_READY_TIMEOUT_MS) {
+      munmap(base, st.st_size);
+      return -1;
+    }
+    usleep(1000);
+  }
+  if ((hash != 0 && header->hash != hash) || header->size != (size_t) st.st_size) {
+    munmap(base, st.st_size);
+    return -1;
+  }
+
+  g->mapping = base;
+  g->mapping_size = st.st_size;
+  g->store.numOfEdges = header->numOfEdges;
+  g->store.numOfVertices = header->numOfVertices;
+  g->store.id_bytes = header->id_bytes;
+  g->store.src = base + header->src_offset;
+  g->store.dst = base + header->dst_offset;
+  g->old_id = header->old_id_offset != 0 ? (int *) (base + header->old_id_offset) : NULL;
+  g->adj.numOfVertices = header->numOfVertices;
+  g->adj.offsets = (int *) (base + header->offsets_offset);
+  g->adj.neighbors = (int *) (base + header->neighbors_offset);
+  g->adj.edge_ids = (int *) (base + header->edge_ids_offset);
+  g->numOfComponents = header->numOfComponents;
+  g->components = (int *) (base + header->components_offset);
+  g->component_edges = (int *) (base + header->component_edges_offset);
+  return 0;
+}
+
+int loadGraph(graph *g, edgeList *list, long reorder_edges, const char *name) {
+  if (list == NULL) {
+    if (attachGraph(g, name, 0, 1) == -1) {
+      printErrAndExit("No graph given and no shared graph found");
+    }
+    return 1;
+  }
+
+  uint64_t hash = hashEdgeList(list);
+  if (attachGraph(g, name, hash, 0) == 0) {
+    freeEdgeList(list);
+    return 1;
+  }
+
+  // First generator of this graph, or the shared graph is a different one
+  graph private_graph;
+  buildGraph(&private_graph, list, reorder_edges, 1);
+  freeEdgeList(list);
+  publishGraph(&private_graph, hash, name);
+  if (attachGraph(g, name, hash, 0) == 0) {
+    freeGraph(&private_graph);
+    return 1;
+  }
+  *g = private_graph;
+  return 0;
+}
+
+void freeGraph(graph *g) {
+  if (g->mapping != NULL) {
+    munmap(g->mapping, g->mapping_size);
+    g->mapping = NULL;
+    return;
+  }
+  freeEdgeStore(&g->store);
+  freeAdjacency(&g->adj);
+  free(g->old_id);
+  free(g->components);
+  free(g->component_edges);
+  g->old_id = NULL;
+  g->components = NULL;
+  g->component_edges = NULL;
+}
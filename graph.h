@@ -0,0 +1,311 @@
+/**
+ * @file graph.h
+ * @author Giancarlo Buenaflor <e51837398@tuwien.ac.at>
+ * @date 18.11.2020
+ *
+ * @brief Provides the graph representations used by the generator.
+ *
+ * The graph module. The edges are parsed from the arguments or from a file (a-b tokens, plain edge lists or DIMACS .col)
+ * into an array of edge structs (see sharedmem.h) and converted into an
+ * edgeStore, a structure-of-arrays layout with separate source and destination arrays. If the vertex ids fit into
+ * 8 or 16 bits, the store uses uint8_t or uint16_t ids, which cuts the memory traffic of the edge scan.
+ * Before the store is built, vertices of degree < 3 are removed (they can always be colored without a conflict) and
+ * the rest is numbered component by component, so every connected component is a range of vertices and edges.
+ * Large graphs are then renumbered (reverse Cuthill-McKee), so the colors of neighbouring vertices lie close to each
+ * other in memory.
+ * The prepared graph (edge store, renumbering and adjacency) is published once in the graph object of the job (SHM_GRAPH_NAME),
+ * all other generators of the same graph map it read-only instead of holding their own copy.
+ */
+
+#ifndef GRAPH_H
+#define GRAPH_H
+
+#include <stdint.h>
+#include "sharedmem.h"
+
+/** Represents the edges in structure-of-arrays layout
+ * @brief src[e] and dst[e] are the vertices of edge e, stored with id_bytes bytes each (1, 2 or 4)
+ */
+typedef struct edgeStore {
+  int numOfEdges;
+  int numOfVertices;
+  int id_bytes;
+  void *src;
+  void *dst;
+} edgeStore;
+
+/** Represents a growing list of edges
+ * @brief edges has room for capacity edges and grows by doubling
+ * numOfVertices is one more than the largest vertex id seen, or the vertex count of a DIMACS problem line if that is larger
+ */
+typedef struct edgeList {
+  edge *edges;
+  int numOfEdges;
+  int capacity;
+  int numOfVertices;
+} edgeList;
+
+/** Represents the adjacency of a graph in compressed sparse row layout
+ * @brief The neighbours of vertex v are neighbors[offsets[v]] to neighbors[offsets[v + 1] - 1]
+ * Every edge u-v appears once at u and once at v, self loops are left out. edge_ids[k] is the index of the edge
+ * that neighbors[k] belongs to.
+ */
+typedef struct adjacency {
+  int numOfVertices;
+  int *offsets;
+  int *neighbors;
+  int *edge_ids;
+} adjacency;
+
+/** Default number of edges from which the generator renumbers the vertices of a graph */
+#define DEFAULT_REORDER_EDGES (4096)
+
+/** Represents a graph prepared for the search
+ * @brief store holds the edges, old_id maps renumbered ids back to input ids (NULL if not renumbered), adj the adjacency
+ * Component k holds the vertices components[k] to components[k + 1] - 1 and the edges component_edges[k] to
+ * component_edges[k + 1] - 1 (numOfComponents + 1 entries each).
+ * If the graph is mapped from the shared graph, all arrays point into mapping (mapping_size bytes, read-only), otherwise mapping is NULL.
+ */
+typedef struct graph {
+  edgeStore store;
+  int *old_id;
+  adjacency adj;
+  int numOfComponents;
+  int *components;
+  int *component_edges;
+  void *mapping;
+  size_t mapping_size;
+} graph;
+
+/** Represents the header of the shared graph segment
+ * @brief ready is set last (release) by the process publishing the graph, hash identifies the input graph
+ * The arrays follow the header at the given byte offsets, old_id_offset is 0 if the graph is not renumbered.
+ * components and component_edges hold numOfComponents + 1 entries each.
+ */
+typedef struct graphHeader {
+  int ready;
+  int numOfVertices;
+  int numOfEdges;
+  int id_bytes;
+  int numOfComponents;
+  uint64_t hash;
+  size_t size;
+  size_t src_offset;
+  size_t dst_offset;
+  size_t old_id_offset;
+  size_t offsets_offset;
+  size_t neighbors_offset;
+  size_t edge_ids_offset;
+  size_t components_offset;
+  size_t component_edges_offset;
+} graphHeader;
+
+/**
+ * Appends an edge to an edge list
+ * @brief Doubles the capacity if the list is full
+ * @details If allocating fails, the function prints an error and exits
+ * @param list The edge list (zero initialized before the first call)
+ * @param source The source vertex (nonnegative)
+ * @param destination The destination vertex (nonnegative)
+*/
+void appendEdge(edgeList *list, int source, int destination);
+
+/**
+ * Frees an edge list
+ * @param list The edge list
+*/
+void freeEdgeList(edgeList *list);
+
+/**
+ * Parses edges given as arguments
+ * @brief Every argument must have the form a-b
+ * @details If an argument cannot be parsed, the function prints an error and exits
+ * @param list The edge list the edges are appended to
+ * @param args The arguments
+ * @param num_args The number of arguments
+*/
+void parseEdgeArgs(edgeList *list, char **args, int num_args);
+
+/**
+ * Parses a graph file
+ * @brief Reads the whole input in a single pass with a hand-written integer parser
+ * @details Every line is either a DIMACS line (c comment, p edge N M, e u v with 1-based ids), a comment starting with # or %,
+ * a plain edge "a b" (further columns are ignored) or any number of whitespace separated a-b tokens.
+ * Regular files are mapped, other inputs (path "-" is stdin) are read into a buffer that grows by doubling.
+ * If the input cannot be read or parsed, the function prints an error and exits
+ * @param list The edge list the edges are appended to
+ * @param path The path of the file, or "-" for stdin
+*/
+void parseGraphFile(edgeList *list, const char *path);
+
+/**
+ * Builds the adjacency of a graph
+ * @brief Counts the degrees, takes their prefix sums as offsets and scatters the neighbours
+ * @details If allocating fails, the function prints an error and exits
+ * @param adj The adjacency to be built
+ * @param edges The edges
+ * @param numOfEdges The number of edges
+ * @param numOfVertices The number of vertices
+*/
+void buildAdjacency(adjacency *adj, const edge edges[], int numOfEdges, int numOfVertices);
+
+/**
+ * Frees an adjacency
+ * @param adj The adjacency
+*/
+void freeAdjacency(adjacency *adj);
+
+/**
+ * Returns the degree of a vertex
+ * @param adj The adjacency
+ * @param v The vertex
+ * @return Returns the number of neighbours of v.
+*/
+static inline int getDegree(const adjacency *adj, int v) {
+  return adj->offsets[v + 1] - adj->offsets[v];
+}
+
+/**
+ * Renumbers the vertices of a graph for cache locality
+ * @brief Computes a reverse Cuthill-McKee order and rewrites the edges with the new ids, sorted by (source, destination)
+ * @details Every component is traversed breadth-first from its vertex of smallest degree, neighbours are visited
+ * by ascending degree, and the resulting order is reversed. The orientation of every edge is kept.
+ * If allocating fails, the function prints an error and exits
+ * @param edges The edges, rewritten in place
+ * @param numOfEdges The number of edges
+ * @param numOfVertices The number of vertices
+ * @return Returns old_id, an array mapping every new id back to the original vertex (free with free()).
+*/
+int *reorderGraph(edge edges[], int numOfEdges, int numOfVertices);
+
+/**
+ * Removes the vertices that never conflict and groups the components
+ * @brief Repeatedly removes vertices with fewer than 3 neighbours together with their edges, then numbers the
+ * remaining vertices by connected component (keeping their order within a component) and sorts the edges by source
+ * @details A removed vertex can always take a color none of its neighbours has, so every coloring of the rest extends
+ * to the whole graph without further conflicts: both have the same solutions. Self loops always conflict and are kept.
+ * Vertices without edges are dropped. If allocating fails, the function prints an error and exits
+ * @param list The edge list, rewritten in place (numOfVertices is the number of remaining vertices)
+ * @return Returns an array mapping every new id back to the vertex of the input (free with free()), or NULL if the
+ * ids didn't change.
+*/
+int *reduceGraph(edgeList *list);
+
+/**
+ * Returns the edges of a component
+ * @param g The graph
+ * @param k The component
+ * @param part The edge store to set up, it shares the arrays of g->store (vertex ids stay those of the graph)
+*/
+static inline void getComponentStore(const graph *g, int k, edgeStore *part) {
+  *part = g->store;
+  part->numOfEdges = g->component_edges[k + 1] - g->component_edges[k];
+  part->src = (unsigned char *) g->store.src + (size_t) g->component_edges[k] * g->store.id_bytes;
+  part->dst = (unsigned char *) g->store.dst + (size_t) g->component_edges[k] * g->store.id_bytes;
+}
+
+/**
+ * Hashes an edge list
+ * @brief FNV-1a over the vertex count and all edges, used to tell whether a shared graph is the same graph
+ * @param list The edge list
+ * @return Returns the hash (never 0).
+*/
+uint64_t hashEdgeList(const edgeList *list);
+
+/**
+ * Prepares a private graph
+ * @brief Reduces the graph (see reduceGraph) if reduce is set, renumbers the vertices if it has at least reorder_edges
+ * edges, then builds the edge store, the adjacency and the components
+ * @details The edges of list are rewritten by the reduction and the renumbering. If allocating fails, the function
+ * prints an error and exits
+ * @param g The graph to be built
+ * @param list The parsed edges
+ * @param reorder_edges The number of edges from which the vertices are renumbered
+ * @param reduce 1 to remove the vertices that never conflict, 0 to keep the graph as it is
+*/
+void buildGraph(graph *g, edgeList *list, long reorder_edges, int reduce);
+
+/**
+ * Loads a graph for a generator
+ * @brief Maps the shared graph if it holds the same graph, otherwise prepares the (reduced) graph and publishes it
+ * @details If list is NULL, the shared graph must exist and is used whatever graph it holds.
+ * If the shared graph holds a different graph, a private graph is used. list is freed in every case.
+ * @param g The graph to be loaded
+ * @param list The parsed edges, or NULL to attach to the shared graph
+ * @param reorder_edges The number of edges from which the vertices are renumbered
+ * @param name The name of the shared graph object, see jobNames
+ * @return Returns 1 if g is mapped from the shared graph, 0 if it is private.
+*/
+int loadGraph(graph *g, edgeList *list, long reorder_edges, const char *name);
+
+/**
+ * Publishes a graph
+ * @brief Creates the shared graph object exclusively and copies the graph into it
+ * @details Fails without an error if the segment already exists. Other errors print an error and exit
+ * @param g The prepared private graph
+ * @param hash The hash of the input edges, see hashEdgeList
+ * @param name The name of the shared graph object, see jobNames
+ * @return Returns 0 if the graph was published, -1 if the segment already exists.
+*/
+int publishGraph(const graph *g, uint64_t hash, const char *name);
+
+/**
+ * Frees a graph
+ * @brief Unmaps a shared graph or frees a private one
+ * @param g The graph
+*/
+void freeGraph(graph *g);
+
+/**
+ * Builds an edge store
+ * @brief Copies the edges into separate source and destination arrays
+ * @details Chooses the narrowest ids (8, 16 or 32 bit) numOfVertices allows. If allocating fails, the function prints an error and exits
+ * @param store The edge store to be built
+ * @param edges The edges
+ * @param numOfEdges The number of edges
+ * @param numOfVertices The number of vertices (all ids are smaller)
+*/
+void buildEdgeStore(edgeStore *store, edge edges[], int numOfEdges, int numOfVertices);
+
+/**
+ * Frees an edge store
+ * @brief Releases the source and destination arrays
+ * @param store The edge store
+*/
+void freeEdgeStore(edgeStore *store);
+
+/**
+ * Returns a vertex id of an edge store
+ * @param ids The source or destination array
+ * @param id_bytes The width of the ids (1, 2 or 4)
+ * @param e The edge index
+ * @return Returns the id of edge e.
+*/
+static inline int getEdgeId(const void *ids, int id_bytes, int e) {
+  if (id_bytes == 1) {
+    return ((const uint8_t *) ids)[e];
+  }
+  return id_bytes == 2 ? ((const uint16_t *) ids)[e] : (int) ((const uint32_t *) ids)[e];
+}
+
+/**
+ * Returns the source of an edge
+ * @param store The edge store
+ * @param e The edge index
+ * @return Returns the source vertex of edge e.
+*/
+static inline int getEdgeSource(const edgeStore *store, int e) {
+  return getEdgeId(store->src, store->id_bytes, e);
+}
+
+/**
+ * Returns the destination of an edge
+ * @param store The edge store
+ * @param e The edge index
+ * @return Returns the destination vertex of edge e.
+*/
+static inline int getEdgeDestination(const edgeStore *store, int e) {
+  return getEdgeId(store->dst, store->id_bytes, e);
+}
+
+#endif
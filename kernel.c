@@ -0,0 +1,519 @@
+/**
+ * @file kernel.c
+ * @author Giancarlo Buenaflor <e51837398@tuwien.ac.at>
+ * @date 18.11.2020
+ * 
+ * @brief Implementation of the kernel module.
+ *
+ **/
+
+#include "kernel.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNELS
+#endif
+
+/** Number of edges the scalar kernels check between two limit checks */
+#define SCALAR_BLOCK (64)
+
+/**
+ * Defines a scalar conflict kernel
+ * @brief The comparison result is added without a branch, the limit is checked once per SCALAR_BLOCK edges
+ * @param name The name of the kernel function
+ * @param id_type The type of the vertex ids
+*/
+#define DEFINE_SCALAR_KERNEL(name, id_type) \
+static int name(const edgeStore *store, const int *color_indices, int limit, int *first) { \
+  const id_type *src = store->src; \
+  const id_type *dst = store->dst; \
+  int n = store->numOfEdges, count = 0; \
+  *first = n; \
+  for (int b = 0; b < n && count < limit; b += SCALAR_BLOCK) { \
+    int end = b + SCALAR_BLOCK < n ? b + SCALAR_BLOCK : n, block = 0; \
+    for (int e = b; e < end; e++) { \
+      block += color_indices[src[e]] == color_indices[dst[e]]; \
+    } \
+    if (block != 0 && count == 0) { \
+      *first = b; \
+    } \
+    count += block; \
+  } \
+  return count; \
+}
+
+DEFINE_SCALAR_KERNEL(scalarKernel8, uint8_t)
+DEFINE_SCALAR_KERNEL(scalarKernel16, uint16_t)
+DEFINE_SCALAR_KERNEL(scalarKernel32, uint32_t)
+
+/**
+ * Counts the conflicts of the edges that don't fill a whole vector block
+ * @param store The edge store
+ * @param color_indices The color_indices array
+ * @param start The first edge to check
+ * @param count The count so far
+ * @param first The first conflicting block (pointer, set if this is the first conflict)
+ * @return Returns the new count.
+*/
+static int countTail(const edgeStore *store, const int *color_indices, int start, int count, int *first) {
+  for (int e = start; e < store->numOfEdges; e++) {
+    if (color_indices[getEdgeSource(store, e)] == color_indices[getEdgeDestination(store, e)]) {
+      if (count++ == 0) {
+        *first = e;
+      }
+    }
+  }
+  return count;
+}
+
+#ifdef HAVE_X86_KERNELS
+/**
+ * Defines an AVX2 conflict kernel
+ * @brief Gathers 8 colors per end, compares them and takes the popcount of the resulting mask
+ * @param name The name of the kernel function
+ * @param id_type The type of the vertex ids
+ * @param load An expression loading 8 ids starting at p as 32 bit lanes
+*/
+#define DEFINE_AVX2_KERNEL(name, id_type, load) \
+__attribute__((target("avx2,popcnt"))) \
+static int name(const edgeStore *store, const int *color_indices, int limit, int *first) { \
+  const id_type *src = store->src; \
+  const id_type *dst = store->dst; \
+  int n = store->numOfEdges, count = 0, e = 0; \
+  *first = n; \
+  for (; e + 8 <= n && count < limit; e += 8) { \
+    const id_type *p = src + e; \
+    __m256i s = load; \
+    p = dst + e; \
+    __m256i d = load; \
+    __m256i cs = _mm256_i32gather_epi32(color_indices, s, 4); \
+    __m256i cd = _mm256_i32gather_epi32(color_indices, d, 4); \
+    int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(cs, cd))); \
+    if (mask != 0 && count == 0) { \
+      *first = e; \
+    } \
+    count += __builtin_popcount(mask); \
+  } \
+  if (count < limit) { \
+    count = countTail(store, color_indices, e, count, first); \
+  } \
+  return count; \
+}
+
+DEFINE_AVX2_KERNEL(avx2Kernel8, uint8_t, _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) p)))
+DEFINE_AVX2_KERNEL(avx2Kernel16, uint16_t, _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *) p)))
+DEFINE_AVX2_KERNEL(avx2Kernel32, uint32_t, _mm256_loadu_si256((const __m256i *) p))
+
+/**
+ * Defines an AVX-512 conflict kernel
+ * @brief Like the AVX2 kernels with 16 edges per block, the comparison directly yields the mask
+ * @param name The name of the kernel function
+ * @param id_type The type of the vertex ids
+ * @param load An expression loading 16 ids starting at p as 32 bit lanes
+*/
+#define DEFINE_AVX512_KERNEL(name, id_type, load) \
+__attribute__((target("avx512f,popcnt"))) \
+static int name(const edgeStore *store, const int *color_indices, int limit, int *first) { \
+  const id_type *src = store->src; \
+  const id_type *dst = store->dst; \
+  int n = store->numOfEdges, count = 0, e = 0; \
+  *first = n; \
+  for (; e + 16 <= n && count < limit; e += 16) { \
+    const id_type *p = src + e; \
+    __m512i s = load; \
+    p = dst + e; \
+    __m512i d = load; \
+    __m512i cs = _mm512_i32gather_epi32(s, color_indices, 4); \
+    __m512i cd = _mm512_i32gather_epi32(d, color_indices, 4); \
+    __mmask16 mask = _mm512_cmpeq_epi32_mask(cs, cd); \
+    if (mask != 0 && count == 0) { \
+      *first = e; \
+    } \
+    count += __builtin_popcount(mask); \
+  } \
+  if (count < limit) { \
+    count = countTail(store, color_indices, e, count, first); \
+  } \
+  return count; \
+}
+
+DEFINE_AVX512_KERNEL(avx512Kernel8, uint8_t, _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i *) p)))
+DEFINE_AVX512_KERNEL(avx512Kernel16, uint16_t, _mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i *) p)))
+DEFINE_AVX512_KERNEL(avx512Kernel32, uint32_t, _mm512_loadu_si512((const void *) p))
+
+#endif
+
+/** Turns the argument into a pragma */
+#define PRAGMA(x) _Pragma(#x)
+
+/**
+ * Defines a small scalar conflict kernel
+ * @brief For stores with at most class_edges edges: the loop has a constant trip count and is fully unrolled, the
+ * limit is never checked
+ * @details first is the exact first conflicting edge, so the bounded scans materialize without a detour
+ * @param name The name of the kernel function
+ * @param id_type The type of the vertex ids
+ * @param color_type The type of the colors (int or uint8_t)
+ * @param class_edges The size class (a literal)
+*/
+#define DEFINE_SCALAR_SMALL_KERNEL(name, id_type, color_type, class_edges) \
+static int name(const edgeStore *store, const color_type *colors, int limit, int *first) { \
+  const id_type *src = store->src; \
+  const id_type *dst = store->dst; \
+  int n = store->numOfEdges, count = 0; \
+  (void) limit; \
+  *first = n; \
+  PRAGMA(GCC unroll class_edges) \
+  for (int e = 0; e < class_edges; e++) { \
+    if (e == n) { \
+      break; \
+    } \
+    int conflict = colors[src[e]] == colors[dst[e]]; \
+    *first = conflict && count == 0 ? e : *first; \
+    count += conflict; \
+  } \
+  return count; \
+}
+
+/**
+ * Defines the small scalar conflict kernels of an id width
+ * @param bits The width of the vertex ids (8, 16 or 32)
+*/
+#define DEFINE_SCALAR_SMALL_KERNELS(bits) \
+DEFINE_SCALAR_SMALL_KERNEL(scalarSmallKernel##bits##x16, uint##bits##_t, int, 16) \
+DEFINE_SCALAR_SMALL_KERNEL(scalarSmallKernel##bits##x64, uint##bits##_t, int, 64) \
+DEFINE_SCALAR_SMALL_KERNEL(scalarSmallByteKernel##bits##x16, uint##bits##_t, uint8_t, 16) \
+DEFINE_SCALAR_SMALL_KERNEL(scalarSmallByteKernel##bits##x64, uint##bits##_t, uint8_t, 64)
+
+DEFINE_SCALAR_SMALL_KERNELS(8)
+DEFINE_SCALAR_SMALL_KERNELS(16)
+DEFINE_SCALAR_SMALL_KERNELS(32)
+
+#ifdef HAVE_X86_KERNELS
+/** Gathers 8 int colors (AVX2) */
+#define GATHER_AVX2_INT(v) _mm256_i32gather_epi32(colors, v, 4)
+
+/** Gathers 8 byte colors (AVX2), every lane reads 4 bytes and keeps the lowest */
+#define GATHER_AVX2_BYTE(v) _mm256_and_si256(_mm256_i32gather_epi32((const int *) colors, v, 1), _mm256_set1_epi32(0xff))
+
+/** Gathers the 16 int colors of the lanes in m (AVX-512) */
+#define GATHER_AVX512_INT(m, v) _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), m, v, colors, 4)
+
+/** Gathers the 16 byte colors of the lanes in m (AVX-512), every lane reads 4 bytes and keeps the lowest */
+#define GATHER_AVX512_BYTE(m, v) \
+  _mm512_and_si512(_mm512_mask_i32gather_epi32(_mm512_setzero_si512(), m, v, colors, 1), _mm512_set1_epi32(0xff))
+
+/**
+ * Defines a small AVX2 conflict kernel
+ * @brief For stores with at most class_edges edges: the loop over the blocks of 8 edges has a constant trip count and
+ * is fully unrolled, the last block is padded instead of falling back to countTail and the limit is never checked
+ * @details The ids of the last block are copied and padded with vertex 0, so nothing past the end of the store is
+ * read, and the padding lanes are masked out of the result. first is the exact first conflicting edge
+ * @param name The name of the kernel function
+ * @param id_type The type of the vertex ids
+ * @param load An expression loading 8 ids starting at p as 32 bit lanes
+ * @param color_type The type of the colors (int or uint8_t)
+ * @param gather The gather macro of the colors
+ * @param class_edges The size class (a literal multiple of 8)
+*/
+#define DEFINE_AVX2_SMALL_KERNEL(name, id_type, load, color_type, gather, class_edges) \
+__attribute__((target("avx2,popcnt"))) \
+static int name(const edgeStore *store, const color_type *colors, int limit, int *first) { \
+  const id_type *src = store->src; \
+  const id_type *dst = store->dst; \
+  int n = store->numOfEdges, count = 0; \
+  (void) limit; \
+  *first = n; \
+  PRAGMA(GCC unroll class_edges) \
+  for (int e = 0; e < class_edges; e += 8) { \
+    if (e >= n) { \
+      break; \
+    } \
+    int rest = n - e < 8 ? n - e : 8; \
+    const id_type *ps = src + e, *pd = dst + e; \
+    id_type padded[2][8] = {{0}}; \
+    if (rest < 8) { \
+      memcpy(padded[0], ps, rest * sizeof(id_type)); \
+      memcpy(padded[1], pd, rest * sizeof(id_type)); \
+      ps = padded[0], pd = padded[1]; \
+    } \
+    const id_type *p = ps; \
+    __m256i s = load; \
+    p = pd; \
+    __m256i d = load; \
+    __m256i equal = _mm256_cmpeq_epi32(gather(s), gather(d)); \
+    int mask = _mm256_movemask_ps(_mm256_castsi256_ps(equal)) & ((1 << rest) - 1); \
+    if (mask != 0 && count == 0) { \
+      *first = e + __builtin_ctz(mask); \
+    } \
+    count += __builtin_popcount(mask); \
+  } \
+  return count; \
+}
+
+/**
+ * Defines a small AVX-512 conflict kernel
+ * @brief Like the small AVX2 kernels with blocks of 16 edges, the last block is masked
+ * @details Masked loads don't touch the ids past the end of the store
+ * @param name The name of the kernel function
+ * @param id_type The type of the vertex ids
+ * @param load An expression loading the ids of valid starting at p as 32 bit lanes
+ * @param color_type The type of the colors (int or uint8_t)
+ * @param gather The gather macro of the colors
+ * @param class_edges The size class (a literal multiple of 16)
+*/
+#define DEFINE_AVX512_SMALL_KERNEL(name, id_type, load, color_type, gather, class_edges) \
+__attribute__((target("avx512f,avx512bw,avx512vl,popcnt"))) \
+static int name(const edgeStore *store, const color_type *colors, int limit, int *first) { \
+  const id_type *src = store->src; \
+  const id_type *dst = store->dst; \
+  int n = store->numOfEdges, count = 0; \
+  (void) limit; \
+  *first = n; \
+  PRAGMA(GCC unroll class_edges) \
+  for (int e = 0; e < class_edges; e += 16) { \
+    if (e >= n) { \
+      break; \
+    } \
+    __mmask16 valid = n - e >= 16 ? 0xffff : (__mmask16) ((1u << (n - e)) - 1); \
+    const id_type *p = src + e; \
+    __m512i s = load; \
+    p = dst + e; \
+    __m512i d = load; \
+    __mmask16 mask = _mm512_mask_cmpeq_epi32_mask(valid, gather(valid, s), gather(valid, d)); \
+    if (mask != 0 && count == 0) { \
+      *first = e + __builtin_ctz(mask); \
+    } \
+    count += __builtin_popcount(mask); \
+  } \
+  return count; \
+}
+
+/**
+ * Defines the small vector conflict kernels of an id width
+ * @param bits The width of the vertex ids (8, 16 or 32)
+ * @param load2 The AVX2 load, see DEFINE_AVX2_SMALL_KERNEL
+ * @param load512 The AVX-512 load, see DEFINE_AVX512_SMALL_KERNEL
+*/
+#define DEFINE_VECTOR_SMALL_KERNELS(bits, load2, load512) \
+DEFINE_AVX2_SMALL_KERNEL(avx2SmallKernel##bits##x16, uint##bits##_t, load2, int, GATHER_AVX2_INT, 16) \
+DEFINE_AVX2_SMALL_KERNEL(avx2SmallKernel##bits##x64, uint##bits##_t, load2, int, GATHER_AVX2_INT, 64) \
+DEFINE_AVX2_SMALL_KERNEL(avx2SmallByteKernel##bits##x16, uint##bits##_t, load2, uint8_t, GATHER_AVX2_BYTE, 16) \
+DEFINE_AVX2_SMALL_KERNEL(avx2SmallByteKernel##bits##x64, uint##bits##_t, load2, uint8_t, GATHER_AVX2_BYTE, 64) \
+DEFINE_AVX512_SMALL_KERNEL(avx512SmallKernel##bits##x16, uint##bits##_t, load512, int, GATHER_AVX512_INT, 16) \
+DEFINE_AVX512_SMALL_KERNEL(avx512SmallKernel##bits##x64, uint##bits##_t, load512, int, GATHER_AVX512_INT, 64) \
+DEFINE_AVX512_SMALL_KERNEL(avx512SmallByteKernel##bits##x16, uint##bits##_t, load512, uint8_t, GATHER_AVX512_BYTE, 16) \
+DEFINE_AVX512_SMALL_KERNEL(avx512SmallByteKernel##bits##x64, uint##bits##_t, load512, uint8_t, GATHER_AVX512_BYTE, 64)
+
+DEFINE_VECTOR_SMALL_KERNELS(8, _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) p)),
+                            _mm512_cvtepu8_epi32(_mm_maskz_loadu_epi8(valid, p)))
+DEFINE_VECTOR_SMALL_KERNELS(16, _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *) p)),
+                            _mm512_cvtepu16_epi32(_mm256_maskz_loadu_epi16(valid, p)))
+DEFINE_VECTOR_SMALL_KERNELS(32, _mm256_loadu_si256((const __m256i *) p), _mm512_maskz_loadu_epi32(valid, p))
+#endif
+
+/** Instruction sets of the kernels */
+typedef enum kernelIsa {
+  ISA_SCALAR = 0,
+  ISA_AVX2,
+  ISA_AVX512,
+  ISA_AVX512_SMALL
+} kernelIsa;
+
+/** Represents a conflict kernel of the dispatch table
+ * @brief Either kernel or byte_kernel (uint8_t colors) is set. The kernel works on stores with id_bytes wide ids and at
+ * most max_edges edges (0 for any number)
+ */
+typedef struct kernelInfo {
+  conflictKernel kernel;
+  byteConflictKernel byte_kernel;
+  const char *name;
+  int id_bytes;
+  int max_edges;
+  kernelIsa isa;
+} kernelInfo;
+
+/**
+ * Dispatch table entries of the small scalar kernels of an id width and size class
+ * @param bits The width of the vertex ids
+ * @param class_edges The size class
+*/
+#define SCALAR_SMALL_ENTRIES(bits, class_edges) \
+  {scalarSmallKernel##bits##x##class_edges, NULL, "scalar-small" #class_edges "-u" #bits, bits / 8, class_edges, ISA_SCALAR}, \
+  {NULL, scalarSmallByteKernel##bits##x##class_edges, "scalar-small" #class_edges "-u" #bits "-c8", bits / 8, class_edges, \
+   ISA_SCALAR},
+
+#ifdef HAVE_X86_KERNELS
+/**
+ * Dispatch table entries of the small vector kernels of an id width and size class, fastest first
+ * @param bits The width of the vertex ids
+ * @param class_edges The size class
+*/
+#define VECTOR_SMALL_ENTRIES(bits, class_edges) \
+  {avx512SmallKernel##bits##x##class_edges, NULL, "avx512-small" #class_edges "-u" #bits, bits / 8, class_edges, \
+   ISA_AVX512_SMALL}, \
+  {NULL, avx512SmallByteKernel##bits##x##class_edges, "avx512-small" #class_edges "-u" #bits "-c8", bits / 8, class_edges, \
+   ISA_AVX512_SMALL}, \
+  {avx2SmallKernel##bits##x##class_edges, NULL, "avx2-small" #class_edges "-u" #bits, bits / 8, class_edges, ISA_AVX2}, \
+  {NULL, avx2SmallByteKernel##bits##x##class_edges, "avx2-small" #class_edges "-u" #bits "-c8", bits / 8, class_edges, \
+   ISA_AVX2},
+
+/**
+ * Dispatch table entries of the general vector kernels of an id width, fastest first
+ * @param bits The width of the vertex ids
+*/
+#define VECTOR_ENTRIES(bits) \
+  {avx512Kernel##bits, NULL, "avx512-u" #bits, bits / 8, 0, ISA_AVX512}, \
+  {avx2Kernel##bits, NULL, "avx2-u" #bits, bits / 8, 0, ISA_AVX2},
+#else
+#define VECTOR_SMALL_ENTRIES(bits, class_edges)
+#define VECTOR_ENTRIES(bits)
+#endif
+
+/**
+ * Dispatch table entries of an id width, the smallest size class and the fastest instruction set first
+ * @param bits The width of the vertex ids
+*/
+#define KERNEL_ENTRIES(bits) \
+  VECTOR_SMALL_ENTRIES(bits, 16) \
+  SCALAR_SMALL_ENTRIES(bits, 16) \
+  VECTOR_SMALL_ENTRIES(bits, 64) \
+  SCALAR_SMALL_ENTRIES(bits, 64) \
+  VECTOR_ENTRIES(bits) \
+  {scalarKernel##bits, NULL, "scalar-u" #bits, bits / 8, 0, ISA_SCALAR},
+
+/** The dispatch table, see KERNEL_ENTRIES */
+static const kernelInfo kernel_table[] = {
+  KERNEL_ENTRIES(8)
+  KERNEL_ENTRIES(16)
+  KERNEL_ENTRIES(32)
+};
+
+/** Number of kernels of the dispatch table */
+#define NUM_KERNELS ((int) (sizeof(kernel_table) / sizeof(kernel_table[0])))
+
+/**
+ * Checks whether a kernel can be used
+ * @param info The kernel
+ * @param store The edge store it would be used on
+ * @return Returns 1 if the kernel fits the id width and size of store and the cpu supports its instruction set.
+*/
+static int isKernelUsable(const kernelInfo *info, const edgeStore *store) {
+  if (info->id_bytes != store->id_bytes || (info->max_edges > 0 && store->numOfEdges > info->max_edges)) {
+    return 0;
+  }
+#ifdef HAVE_X86_KERNELS
+  __builtin_cpu_init();
+  if (info->isa == ISA_AVX512_SMALL) {
+    return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl");
+  }
+  if (info->isa == ISA_AVX512) {
+    return __builtin_cpu_supports("avx512f");
+  }
+  if (info->isa == ISA_AVX2) {
+    return __builtin_cpu_supports("avx2");
+  }
+#endif
+  return info->isa == ISA_SCALAR;
+}
+
+conflictKernel selectConflictKernel(const edgeStore *store) {
+  for (int i = 0; i < NUM_KERNELS; i++) {
+    if (kernel_table[i].kernel != NULL && isKernelUsable(&kernel_table[i], store)) {
+      return kernel_table[i].kernel;
+    }
+  }
+  return scalarKernel32;
+}
+
+byteConflictKernel selectByteConflictKernel(const edgeStore *store) {
+  for (int i = 0; i < NUM_KERNELS; i++) {
+    if (kernel_table[i].byte_kernel != NULL && isKernelUsable(&kernel_table[i], store)) {
+      return kernel_table[i].byte_kernel;
+    }
+  }
+  return NULL;
+}
+
+int listConflictKernels(const edgeStore *store, conflictKernel kernels[]) {
+  int count = 0;
+  for (int i = NUM_KERNELS - 1; i >= 0; i--) {
+    if (kernel_table[i].kernel != NULL && isKernelUsable(&kernel_table[i], store)) {
+      kernels[count++] = kernel_table[i].kernel;
+    }
+  }
+  return count;
+}
+
+int listByteConflictKernels(const edgeStore *store, byteConflictKernel kernels[]) {
+  int count = 0;
+  for (int i = NUM_KERNELS - 1; i >= 0; i--) {
+    if (kernel_table[i].byte_kernel != NULL && isKernelUsable(&kernel_table[i], store)) {
+      kernels[count++] = kernel_table[i].byte_kernel;
+    }
+  }
+  return count;
+}
+
+const char *getConflictKernelName(conflictKernel kernel) {
+  for (int i = 0; i < NUM_KERNELS; i++) {
+    if (kernel_table[i].kernel == kernel) {
+      return kernel_table[i].name;
+    }
+  }
+  return "unknown";
+}
+
+const char *getByteConflictKernelName(byteConflictKernel kernel) {
+  for (int i = 0; i < NUM_KERNELS; i++) {
+    if (kernel_table[i].byte_kernel == kernel) {
+      return kernel_table[i].name;
+    }
+  }
+  return "unknown";
+}
+
+int solveEdgeStoreBounded(conflictKernel kernel, const edgeStore *store, const int *color_indices, int bound, edge removed_edges[], int *removed_edges_count) {
+  if (bound < 0) {
+    return 0;
+  }
+  int first;
+  int count = kernel(store, color_indices, bound + 1, &first);
+  if (count > bound) {
+    return 0;
+  }
+
+  // Winner, materialize from the first conflicting block until all conflicting edges are written
+  int rem_count = 0;
+  for (int e = first; rem_count < count; e++) {
+    int source = getEdgeSource(store, e);
+    int destination = getEdgeDestination(store, e);
+    if (color_indices[source] == color_indices[destination]) {
+      removed_edges[rem_count].destination = source;
+      removed_edges[rem_count].source = destination;
+      rem_count += 1;
+    }
+  }
+  *removed_edges_count = rem_count;
+  return 1;
+}
+
+int listEdgeStoreConflicts(conflictKernel kernel, const edgeStore *store, const int *color_indices, int bound, int edge_ids[], int *edge_ids_count) {
+  if (bound < 0) {
+    return 0;
+  }
+  int first;
+  int count = kernel(store, color_indices, bound + 1, &first);
+  if (count > bound) {
+    return 0;
+  }
+
+  int rem_count = 0;
+  for (int e = first; rem_count < count; e++) {
+    if (color_indices[getEdgeSource(store, e)] == color_indices[getEdgeDestination(store, e)]) {
+      edge_ids[rem_count++] = e;
+    }
+  }
+  *edge_ids_count = rem_count;
+  return 1;
+}
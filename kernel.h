@@ -0,0 +1,113 @@
+/**
+ * @file kernel.h
+ * @author Giancarlo Buenaflor <e51837398@tuwien.ac.at>
+ * @date 18.11.2020
+ *
+ * @brief Provides the edge conflict kernels, the innermost loop of the generator.
+ *
+ * The kernel module. A kernel scans an edgeStore in blocks, gathers the colors of both ends of every edge,
+ * compares them into a conflict bitmask and adds its popcount. Scalar, AVX2 and AVX-512 kernels exist for
+ * 8, 16 and 32 bit vertex ids. Stores of at most 16 or 64 edges (small graphs and small components, see
+ * getComponentStore) get scalar, AVX2 and AVX-512 kernels whose loop is fully unrolled for that size class instead,
+ * and additionally kernels that read 8 bit colors. A dispatch table picks the fastest kernel for the id width, the
+ * size and the cpu once per store, see selectConflictKernel.
+ */
+
+#ifndef KERNEL_H
+#define KERNEL_H
+
+#include "graph.h"
+
+/** Represents a conflict kernel
+ * @brief Counts the edges of store whose vertices have the same color in color_indices
+ * @details The scan stops after the first block in which the count reaches limit, so the result may exceed limit.
+ * first is set to the index of the first edge of the first block that contains a conflict (numOfEdges if there is none)
+ * @return Returns the number of conflicting edges seen.
+ */
+typedef int (*conflictKernel)(const edgeStore *store, const int *color_indices, int limit, int *first);
+
+/** Represents a conflict kernel on 8 bit colors
+ * @brief Like conflictKernel, only for stores of at most 64 edges. At least 3 bytes after the last color must be
+ * readable, the vector kernels gather 4 bytes per vertex and keep the lowest
+ */
+typedef int (*byteConflictKernel)(const edgeStore *store, const uint8_t *colors, int limit, int *first);
+
+/**
+ * Selects the conflict kernel
+ * @brief Picks the kernel for the id width and size class of store and the fastest instruction set the cpu supports
+ * @param store The edge store the kernel will be used on
+ * @return Returns the conflict kernel.
+*/
+conflictKernel selectConflictKernel(const edgeStore *store);
+
+/**
+ * Selects the conflict kernel on 8 bit colors
+ * @brief Like selectConflictKernel
+ * @param store The edge store the kernel will be used on
+ * @return Returns the conflict kernel or NULL if store has more than 64 edges.
+*/
+byteConflictKernel selectByteConflictKernel(const edgeStore *store);
+
+/** Maximum number of kernels listConflictKernels and listByteConflictKernels return */
+#define MAX_CONFLICT_KERNELS (9)
+
+/**
+ * Lists the usable conflict kernels
+ * @brief Returns every kernel for the id width and size class of store that the cpu supports, slowest first
+ * @param store The edge store the kernels will be used on
+ * @param kernels The kernels (room for MAX_CONFLICT_KERNELS)
+ * @return Returns the number of kernels.
+*/
+int listConflictKernels(const edgeStore *store, conflictKernel kernels[]);
+
+/**
+ * Lists the usable conflict kernels on 8 bit colors
+ * @brief Like listConflictKernels
+ * @param store The edge store the kernels will be used on
+ * @param kernels The kernels (room for MAX_CONFLICT_KERNELS)
+ * @return Returns the number of kernels, 0 if store has more than 64 edges.
+*/
+int listByteConflictKernels(const edgeStore *store, byteConflictKernel kernels[]);
+
+/**
+ * Name of a conflict kernel
+ * @param kernel The kernel
+ * @return Returns a short name like "avx2-u16" or "avx512-small64-u8".
+*/
+const char *getConflictKernelName(conflictKernel kernel);
+
+/**
+ * Name of a conflict kernel on 8 bit colors
+ * @param kernel The kernel
+ * @return Returns a short name like "avx2-small16-u8-c8".
+*/
+const char *getByteConflictKernelName(byteConflictKernel kernel);
+
+/**
+ * Bounded algorithm for the 3-color problem on an edge store
+ * @brief Like solveColorProblemBounded, the counting is done by kernel
+ * @details Only if at most bound edges conflict, they are materialized into removed_edges starting at the first conflicting block
+ * @param kernel The conflict kernel, see selectConflictKernel
+ * @param store The edge store
+ * @param color_indices The color_indices array
+ * @param bound The maximum number of removed edges that is still accepted
+ * @param removed_edges The removed_edges array that will be filled (at least bound entries)
+ * @param removed_edges_count The count for removed_edges (pointer, only set if the coloring is accepted)
+ * @return Returns 1 if at most bound edges are removed, 0 otherwise.
+*/
+int solveEdgeStoreBounded(conflictKernel kernel, const edgeStore *store, const int *color_indices, int bound, edge removed_edges[], int *removed_edges_count);
+
+/**
+ * Bounded listing of the conflicting edge indices
+ * @brief Like solveEdgeStoreBounded, but writes the index of every conflicting edge (in ascending order)
+ * @param kernel The conflict kernel, see selectConflictKernel
+ * @param store The edge store
+ * @param color_indices The color_indices array
+ * @param bound The maximum number of removed edges that is still accepted
+ * @param edge_ids The array that will be filled (at least bound entries)
+ * @param edge_ids_count The count for edge_ids (pointer, only set if the coloring is accepted)
+ * @return Returns 1 if at most bound edges conflict, 0 otherwise.
+*/
+int listEdgeStoreConflicts(conflictKernel kernel, const edgeStore *store, const int *color_indices, int bound, int edge_ids[], int *edge_ids_count);
+
+#endif
@@ -0,0 +1,163 @@
+/**
+ * @file net.c
+ * @author Giancarlo Buenaflor <e51837398@tuwien.ac.at>
+ * @date 18.11.2020
+ *
+ * @brief Implementation of the net module.
+ *
+ **/
+
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include "net.h"
+
+/**
+ * Writes a buffer completely
+ * @param fd The socket
+ * @param buffer The bytes
+ * @param size The number of bytes
+ * @return Returns 0 on success, -1 if the connection failed.
+*/
+static int writeAll(int fd, const void *buffer, size_t size) {
+  const unsigned char *p = buffer;
+  while (size > 0) {
+    ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+    if (n == -1 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return -1;
+    }
+    p += n;
+    size -= n;
+  }
+  return 0;
+}
+
+/**
+ * Reads a buffer completely
+ * @param fd The socket
+ * @param buffer The bytes
+ * @param size The number of bytes
+ * @return Returns 0 on success, -1 if the connection closed or failed.
+*/
+static int readAll(int fd, void *buffer, size_t size) {
+  unsigned char *p = buffer;
+  while (size > 0) {
+    ssize_t n = recv(fd, p, size, 0);
+    if (n == -1 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return -1;
+    }
+    p += n;
+    size -= n;
+  }
+  return 0;
+}
+
+int netListen(int port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd == -1) {
+    printErrAndExit("Creating socket failed");
+  }
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  struct sockaddr_in addr = {
+    .sin_family = AF_INET,
+    .sin_port = htons(port),
+    .sin_addr.s_addr = htonl(INADDR_ANY)
+  };
+  if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) == -1) {
+    printErrAndExit("Binding socket failed");
+  }
+  if (listen(fd, SOMAXCONN) == -1) {
+    printErrAndExit("Listening on socket failed");
+  }
+  return fd;
+}
+
+int netConnect(const char *address) {
+  char host[256];
+  const char *colon = strrchr(address, ':');
+  if (colon == NULL || colon == address || (size_t) (colon - address) >= sizeof(host)) {
+    printErrAndExit("Invalid supervisor address");
+  }
+  memcpy(host, address, colon - address);
+  host[colon - address] = '\0';
+
+  struct addrinfo hints = {
+    .ai_family = AF_UNSPEC,
+    .ai_socktype = SOCK_STREAM
+  };
+  struct addrinfo *result;
+  if (getaddrinfo(host, colon + 1, &hints, &result) != 0) {
+    printErrAndExit("Resolving supervisor address failed");
+  }
+  int fd = -1;
+  for (struct addrinfo *ai = result; ai != NULL && fd == -1; ai = ai->ai_next) {
+    fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (fd != -1 && connect(fd, ai->ai_addr, ai->ai_addrlen) == -1) {
+      close(fd);
+      fd = -1;
+    }
+  }
+  freeaddrinfo(result);
+  if (fd == -1) {
+    printErrAndExit("Connecting to supervisor failed");
+  }
+  // Solutions are small and rare, they should not wait for more data
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  return fd;
+}
+
+int netSend(int fd, netType type, uint32_t value, uint32_t format, const void *payload, uint32_t length) {
+  netHeader header = {
+    .magic = htonl(NET_MAGIC),
+    .type = htonl(type),
+    .value = htonl(value),
+    .format = htonl(format),
+    .length = htonl(length)
+  };
+  if (writeAll(fd, &header, sizeof(header)) == -1) {
+    return -1;
+  }
+  return writeAll(fd, payload, length);
+}
+
+int netReceive(int fd, netHeader *header, void *payload, uint32_t capacity) {
+  if (readAll(fd, header, sizeof(netHeader)) == -1) {
+    return -1;
+  }
+  header->magic = ntohl(header->magic);
+  header->type = ntohl(header->type);
+  header->value = ntohl(header->value);
+  header->format = ntohl(header->format);
+  header->length = ntohl(header->length);
+  if (header->magic != NET_MAGIC || header->length > capacity) {
+    return -1;
+  }
+  return readAll(fd, payload, header->length);
+}
+
+void netEncodeEdges(unsigned char *out, const edge edges[], int count) {
+  for (int i = 0; i < count; i++) {
+    uint32_t pair[2] = {htonl(edges[i].source), htonl(edges[i].destination)};
+    memcpy(out + 8 * (size_t) i, pair, sizeof(pair));
+  }
+}
+
+void netDecodeEdges(edge edges[], const unsigned char *in, int count) {
+  for (int i = 0; i < count; i++) {
+    uint32_t pair[2];
+    memcpy(pair, in + 8 * (size_t) i, sizeof(pair));
+    edges[i].source = ntohl(pair[0]);
+    edges[i].destination = ntohl(pair[1]);
+  }
+}
@@ -0,0 +1,101 @@
+/**
+ * @file net.h
+ * @author Giancarlo Buenaflor <e51837398@tuwien.ac.at>
+ * @date 18.11.2020
+ *
+ * @brief Provides the network transport between remote generators and the supervisor.
+ *
+ * The net module. Generators on other hosts connect to a supervisor started with -l over TCP. Every message is a
+ * netHeader followed by length payload bytes, all integers in network byte order:
+ * NET_HELLO (generator): payload is the job id (empty for the default job).
+ * NET_WELCOME (supervisor): value is the best solution so far, the payload holds the capacity and max_edges of the job.
+ * NET_SOLUTION (generator): value is the number of removed edges, format the solutionFormat (only SOLUTION_EDGES, a
+ * remote generator has no shared graph in common with the supervisor), the payload the removed edges as id pairs.
+ * NET_BEST (supervisor): value is the new best solution of the job, 0 ends the job.
+ */
+
+#ifndef NET_H
+#define NET_H
+
+#include <stdint.h>
+#include "sharedmem.h"
+
+#define NET_MAGIC (0x33434f4cu)
+
+/** Represents the message types */
+typedef enum netType {
+  NET_HELLO = 1,
+  NET_WELCOME,
+  NET_SOLUTION,
+  NET_BEST
+} netType;
+
+/** Represents the header of a message
+ * @brief magic is NET_MAGIC, length the number of payload bytes following the header
+ */
+typedef struct netHeader {
+  uint32_t magic;
+  uint32_t type;
+  uint32_t value;
+  uint32_t format;
+  uint32_t length;
+} netHeader;
+
+/**
+ * Opens a listening socket
+ * @brief Binds to port on all interfaces
+ * @details If any step fails, the function prints an error and exits
+ * @param port The TCP port
+ * @return Returns the socket.
+*/
+int netListen(int port);
+
+/**
+ * Connects to a supervisor
+ * @details If the address cannot be resolved or connected, the function prints an error and exits
+ * @param address The address as host:port
+ * @return Returns the socket.
+*/
+int netConnect(const char *address);
+
+/**
+ * Sends a message
+ * @brief Writes the header and the payload completely
+ * @param fd The socket
+ * @param type The message type
+ * @param value The value field
+ * @param format The format field
+ * @param payload The payload (length bytes)
+ * @param length The number of payload bytes
+ * @return Returns 0 on success, -1 if the connection failed.
+*/
+int netSend(int fd, netType type, uint32_t value, uint32_t format, const void *payload, uint32_t length);
+
+/**
+ * Receives a message
+ * @brief Reads a header (converted to host byte order) and its payload completely
+ * @param fd The socket
+ * @param header The header to fill
+ * @param payload The buffer for the payload
+ * @param capacity The size of payload
+ * @return Returns 0 on success, -1 if the connection closed or failed or the message is invalid or too large.
+*/
+int netReceive(int fd, netHeader *header, void *payload, uint32_t capacity);
+
+/**
+ * Converts edges to network byte order
+ * @param out The buffer (8 bytes per edge)
+ * @param edges The edges
+ * @param count The number of edges
+*/
+void netEncodeEdges(unsigned char *out, const edge edges[], int count);
+
+/**
+ * Converts edges from network byte order
+ * @param edges The edges to fill
+ * @param in The buffer (8 bytes per edge)
+ * @param count The number of edges
+*/
+void netDecodeEdges(edge edges[], const unsigned char *in, int count);
+
+#endif
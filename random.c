@@ -0,0 +1,266 @@
+/**
+ * @file random.c
+ * @author Giancarlo Buenaflor <e51837398@tuwien.ac.at>
+ * @date 18.11.2020
+ * 
+ * @brief Implementation of the random module.
+ *
+ **/
+
+#include "random.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_AVX2_SAMPLER
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define HAVE_NEON_SAMPLER
+#endif
+
+/** Number of colors produced by one step of a block sampler */
+#define BLOCK_COLORS (16)
+
+/** Represents a sampler producing BLOCK_COLORS colors (1 to 3) at a time
+ * @brief The colors are written as 16 bit values to out
+ */
+typedef void (*blockSampler)(rng *r, uint16_t out[BLOCK_COLORS]);
+
+/**
+ * One step of splitmix64
+ * @brief Advances the seed and returns a well mixed 64 bit value
+ * @param seed The seed (pointer, will be advanced)
+ * @return Returns the mixed value.
+*/
+static uint64_t splitmix64(uint64_t *seed) {
+  uint64_t z = (*seed += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+void seedRng(rng *r, uint64_t seed) {
+  for (int i = 0; i < 4; i++) {
+    r->s[i] = splitmix64(&seed);
+  }
+  for (int j = 0; j < 4; j++) {
+    for (int i = 0; i < 4; i++) {
+      r->lanes[i][j] = splitmix64(&seed);
+    }
+  }
+}
+
+/**
+ * Draws a single color
+ * @brief Rejects the lane value 0, see randomizeColors
+ * @param r The state
+ * @return Returns a color from 1 to 3.
+*/
+static uint16_t nextColor(rng *r) {
+  uint32_t h;
+  do {
+    h = nextRandom(r) >> 48;
+  } while (h == 0);
+  return 1 + ((3 * h) >> 16);
+}
+
+/**
+ * Scalar block sampler
+ * @brief Splits four 64 bit draws into 16 lanes of 16 bits
+ * @param r The state
+ * @param out The colors
+*/
+static void scalarBlock(rng *r, uint16_t out[BLOCK_COLORS]) {
+  for (int i = 0; i < BLOCK_COLORS; i += 4) {
+    uint64_t x = nextRandom(r);
+    for (int j = 0; j < 4; j++) {
+      uint32_t h = (x >> (16 * j)) & 0xffff;
+      out[i + j] = h != 0 ? 1 + ((3 * h) >> 16) : nextColor(r);
+    }
+  }
+}
+
+#ifdef HAVE_AVX2_SAMPLER
+/**
+ * Rotates every 64 bit lane left
+ * @param x The lanes
+ * @param k The number of bits
+ * @return Returns the rotated lanes.
+*/
+#define ROTL256(x, k) _mm256_or_si256(_mm256_slli_epi64((x), (k)), _mm256_srli_epi64((x), 64 - (k)))
+
+/**
+ * AVX2 block sampler
+ * @brief Advances the four lane streams at once, the multiplications by 5 and 9 are done with shifts and adds
+ * @details mulhi_epu16 by 3 is exactly (3 * h) >> 16 for all 16 lanes
+ * @param r The state
+ * @param out The colors
+*/
+__attribute__((target("avx2")))
+static void avx2Block(rng *r, uint16_t out[BLOCK_COLORS]) {
+  __m256i s0 = _mm256_loadu_si256((__m256i *) r->lanes[0]);
+  __m256i s1 = _mm256_loadu_si256((__m256i *) r->lanes[1]);
+  __m256i s2 = _mm256_loadu_si256((__m256i *) r->lanes[2]);
+  __m256i s3 = _mm256_loadu_si256((__m256i *) r->lanes[3]);
+
+  __m256i x = _mm256_add_epi64(s1, _mm256_slli_epi64(s1, 2));
+  x = ROTL256(x, 7);
+  __m256i result = _mm256_add_epi64(x, _mm256_slli_epi64(x, 3));
+  __m256i t = _mm256_slli_epi64(s1, 17);
+  s2 = _mm256_xor_si256(s2, s0);
+  s3 = _mm256_xor_si256(s3, s1);
+  s1 = _mm256_xor_si256(s1, s2);
+  s0 = _mm256_xor_si256(s0, s3);
+  s2 = _mm256_xor_si256(s2, t);
+  s3 = ROTL256(s3, 45);
+
+  _mm256_storeu_si256((__m256i *) r->lanes[0], s0);
+  _mm256_storeu_si256((__m256i *) r->lanes[1], s1);
+  _mm256_storeu_si256((__m256i *) r->lanes[2], s2);
+  _mm256_storeu_si256((__m256i *) r->lanes[3], s3);
+
+  __m256i colors = _mm256_add_epi16(_mm256_mulhi_epu16(result, _mm256_set1_epi16(3)), _mm256_set1_epi16(1));
+  _mm256_storeu_si256((__m256i *) out, colors);
+  if (_mm256_movemask_epi8(_mm256_cmpeq_epi16(result, _mm256_setzero_si256())) != 0) {
+    uint16_t lanes[BLOCK_COLORS];
+    _mm256_storeu_si256((__m256i *) lanes, result);
+    for (int i = 0; i < BLOCK_COLORS; i++) {
+      if (lanes[i] == 0) {
+        out[i] = nextColor(r);
+      }
+    }
+  }
+}
+#endif
+
+#ifdef HAVE_NEON_SAMPLER
+/**
+ * Rotates every 64 bit lane left
+ * @param x The lanes
+ * @param k The number of bits
+ * @return Returns the rotated lanes.
+*/
+#define ROTL128(x, k) vorrq_u64(vshlq_n_u64((x), (k)), vshrq_n_u64((x), 64 - (k)))
+
+/**
+ * NEON block sampler
+ * @brief Advances the four lane streams as two pairs, see avx2Block
+ * @param r The state
+ * @param out The colors
+*/
+static void neonBlock(rng *r, uint16_t out[BLOCK_COLORS]) {
+  for (int half = 0; half < 2; half++) {
+    uint64x2_t s0 = vld1q_u64(&r->lanes[0][2 * half]);
+    uint64x2_t s1 = vld1q_u64(&r->lanes[1][2 * half]);
+    uint64x2_t s2 = vld1q_u64(&r->lanes[2][2 * half]);
+    uint64x2_t s3 = vld1q_u64(&r->lanes[3][2 * half]);
+
+    uint64x2_t x = vaddq_u64(s1, vshlq_n_u64(s1, 2));
+    x = ROTL128(x, 7);
+    uint64x2_t result = vaddq_u64(x, vshlq_n_u64(x, 3));
+    uint64x2_t t = vshlq_n_u64(s1, 17);
+    s2 = veorq_u64(s2, s0);
+    s3 = veorq_u64(s3, s1);
+    s1 = veorq_u64(s1, s2);
+    s0 = veorq_u64(s0, s3);
+    s2 = veorq_u64(s2, t);
+    s3 = ROTL128(s3, 45);
+
+    vst1q_u64(&r->lanes[0][2 * half], s0);
+    vst1q_u64(&r->lanes[1][2 * half], s1);
+    vst1q_u64(&r->lanes[2][2 * half], s2);
+    vst1q_u64(&r->lanes[3][2 * half], s3);
+
+    uint16x8_t h = vreinterpretq_u16_u64(result);
+    uint16x4_t lo = vshrn_n_u32(vmull_n_u16(vget_low_u16(h), 3), 16);
+    uint16x4_t hi = vshrn_n_u32(vmull_n_u16(vget_high_u16(h), 3), 16);
+    vst1q_u16(&out[8 * half], vaddq_u16(vcombine_u16(lo, hi), vdupq_n_u16(1)));
+    if (vmaxvq_u16(vceqzq_u16(h)) != 0) {
+      uint16_t lanes[8];
+      vst1q_u16(lanes, h);
+      for (int i = 0; i < 8; i++) {
+        if (lanes[i] == 0) {
+          out[8 * half + i] = nextColor(r);
+        }
+      }
+    }
+  }
+}
+#endif
+
+/**
+ * Selects the block sampler
+ * @brief Picks the fastest sampler the cpu supports, the choice is made once
+ * @return Returns the block sampler.
+*/
+static blockSampler getBlockSampler() {
+  static blockSampler sampler = NULL;
+  blockSampler s = __atomic_load_n(&sampler, __ATOMIC_RELAXED);
+  if (s == NULL) {
+    s = scalarBlock;
+#if defined(HAVE_AVX2_SAMPLER)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+      s = avx2Block;
+    }
+#elif defined(HAVE_NEON_SAMPLER)
+    s = neonBlock;
+#endif
+    __atomic_store_n(&sampler, s, __ATOMIC_RELAXED);
+  }
+  return s;
+}
+
+void randomizeColors(rng *r, int numOfVertices, int *color_indices) {
+  blockSampler sample = getBlockSampler();
+  uint16_t block[BLOCK_COLORS];
+  for (int v = 0; v < numOfVertices; v += BLOCK_COLORS) {
+    sample(r, block);
+    int n = numOfVertices - v < BLOCK_COLORS ? numOfVertices - v : BLOCK_COLORS;
+    for (int i = 0; i < n; i++) {
+      color_indices[v + i] = block[i];
+    }
+  }
+}
+
+void randomizeColorsBytes(rng *r, int numOfVertices, uint8_t *colors) {
+  blockSampler sample = getBlockSampler();
+  uint16_t block[BLOCK_COLORS];
+  for (int v = 0; v < numOfVertices; v += BLOCK_COLORS) {
+    sample(r, block);
+    int n = numOfVertices - v < BLOCK_COLORS ? numOfVertices - v : BLOCK_COLORS;
+    for (int i = 0; i < n; i++) {
+      colors[v + i] = (uint8_t) block[i];
+    }
+  }
+}
+
+/**
+ * Packs a block of colors
+ * @brief Writes 2 bits per color, the first color in the lowest bits
+ * @param block The colors
+ * @return Returns the packed colors.
+*/
+static uint32_t packBlock(const uint16_t block[BLOCK_COLORS]) {
+  uint32_t packed = 0;
+  for (int i = 0; i < BLOCK_COLORS; i++) {
+    packed |= (uint32_t) block[i] << (2 * i);
+  }
+  return packed;
+}
+
+void randomizeColorsPacked(rng *r, int numOfVertices, uint64_t *packed) {
+  blockSampler sample = getBlockSampler();
+  uint16_t block[BLOCK_COLORS];
+  int words = getPackedWords(numOfVertices);
+  for (int w = 0; w < words; w++) {
+    sample(r, block);
+    uint64_t word = packBlock(block);
+    sample(r, block);
+    word |= (uint64_t) packBlock(block) << 32;
+    packed[w] = word;
+  }
+  int rest = numOfVertices % PACKED_COLORS_PER_WORD;
+  if (rest != 0) {
+    packed[words - 1] &= (1ULL << (2 * rest)) - 1;
+  }
+}
@@ -0,0 +1,122 @@
+/**
+ * @file random.h
+ * @author Giancarlo Buenaflor <e51837398@tuwien.ac.at>
+ * @date 18.11.2020
+ *
+ * @brief Provides a fast, thread-safe pseudo random number generator and the random coloring of a graph.
+ *
+ * The random module. Every worker owns an rng state (xoshiro256**), so no state is shared between threads
+ * and no locks are needed, unlike the global state of rand(). Colorings are drawn in bulk: every 64 bit draw
+ * gives four 16 bit lanes, each reduced to a color with a multiply-shift. The AVX2 and NEON paths run four
+ * xoshiro256** streams side by side and produce 16 colors per step.
+ */
+
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <stdint.h>
+
+/** Number of colors held by one word of a packed coloring (2 bits per vertex) */
+#define PACKED_COLORS_PER_WORD (32)
+
+/** Represents the state of the pseudo random number generator
+ * @brief 256 bits of xoshiro256** state, must not be all zero (seedRng takes care of that)
+ * lanes holds four more independent streams (lanes[i][j] is word i of stream j) for the vectorized color sampler
+ */
+typedef struct rng {
+  uint64_t s[4];
+  uint64_t lanes[4][4];
+} rng;
+
+/**
+ * Seeds the pseudo random number generator
+ * @brief Expands a 64 bit seed into the full state with splitmix64
+ * @details Different seeds give statistically independent streams
+ * @param r The state to be seeded
+ * @param seed The seed
+*/
+void seedRng(rng *r, uint64_t seed);
+
+/**
+ * Draws the next random number
+ * @brief One step of xoshiro256**
+ * @param r The state
+ * @return Returns 64 uniformly distributed random bits.
+*/
+static inline uint64_t nextRandom(rng *r) {
+  uint64_t *s = r->s;
+  uint64_t x = s[1] * 5;
+  uint64_t result = ((x << 7) | (x >> 57)) * 9;
+  uint64_t t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = (s[3] << 45) | (s[3] >> 19);
+  return result;
+}
+
+/**
+ * Draws a random number below bound
+ * @brief Lemire's multiply-shift reduction of 32 random bits
+ * @details The bias is below bound / 2^32, which is negligible for the bounds used here
+ * @param r The state
+ * @param bound The exclusive upper bound (> 0)
+ * @return Returns a number in [0, bound).
+*/
+static inline uint32_t nextBounded(rng *r, uint32_t bound) {
+  return (uint32_t) (((nextRandom(r) >> 32) * bound) >> 32);
+}
+
+/**
+ * Randomizes the colors for the 3-colorable algorithm
+ * @brief Each color_indices cell will be assigned a random color
+ * @details Each cell in color_indices array represents a color (integer from 1 inclusive to 3 inclusive) which will be randomly created.
+ * A 16 bit lane h is mapped to 1 + (3 * h) >> 16 and h == 0 is rejected, which leaves 65535 values and makes all colors exactly equally likely.
+ * Uses AVX2 or NEON if the cpu supports it.
+ * @param r The state of the calling worker
+ * @param numOfVertices The number of vertices
+ * @param color_indices The color_indices int array
+*/
+void randomizeColors(rng *r, int numOfVertices, int *color_indices);
+
+/**
+ * Randomizes the colors into bytes
+ * @brief Like randomizeColors, but writes one byte per vertex
+ * @param r The state of the calling worker
+ * @param numOfVertices The number of vertices
+ * @param colors The colors
+*/
+void randomizeColorsBytes(rng *r, int numOfVertices, uint8_t *colors);
+
+/**
+ * Randomizes a packed coloring
+ * @brief Like randomizeColors, but writes 2 bits per vertex
+ * @details Vertex v is stored in bits 2 * (v % 32) and 2 * (v % 32) + 1 of packed[v / 32], unused bits of the last word are 0
+ * @param r The state of the calling worker
+ * @param numOfVertices The number of vertices
+ * @param packed The packed coloring (getPackedWords(numOfVertices) words)
+*/
+void randomizeColorsPacked(rng *r, int numOfVertices, uint64_t *packed);
+
+/**
+ * Size of a packed coloring
+ * @param numOfVertices The number of vertices
+ * @return Returns the number of words needed for numOfVertices packed colors.
+*/
+static inline int getPackedWords(int numOfVertices) {
+  return (numOfVertices + PACKED_COLORS_PER_WORD - 1) / PACKED_COLORS_PER_WORD;
+}
+
+/**
+ * Reads a color of a packed coloring
+ * @param packed The packed coloring
+ * @param v The vertex
+ * @return Returns the color of v (1 to 3).
+*/
+static inline int getPackedColor(const uint64_t *packed, int v) {
+  return (packed[v / PACKED_COLORS_PER_WORD] >> (2 * (v % PACKED_COLORS_PER_WORD))) & 3;
+}
+
+#endif
@@ -0,0 +1,420 @@
+/**
+ * @file search.c
+ * @author Giancarlo Buenaflor <e51837398@tuwien.ac.at>
+ * @date 18.11.2020
+ * 
+ * @brief Implementation of the search module.
+ *
+ **/
+
+#include <limits.h>
+#include "search.h"
+
+/** Maximum number of moves of one local search step */
+#define LOCAL_SEARCH_BATCH (256)
+
+/** Maximum number of nodes of one exact search step */
+#define EXACT_BATCH (4096)
+
+/** Probability (in 1/1024) that min-conflicts makes a random move instead of the best one */
+#define MINCONF_NOISE (100)
+
+/** Maximum number of conflicting vertices tabu search evaluates per move */
+#define TABU_CANDIDATES (128)
+
+/** Random part of the tabu tenure, added to 0.6 times the number of conflicting vertices */
+#define TABU_TENURE_RANDOM (10)
+
+/** Probability (in 1/1024) that a local search restarts from the elite pool instead of a fresh coloring */
+#define ELITE_RESTART (768)
+
+/** A restart from a single member of the elite pool recolors numOfVertices / ELITE_PERTURBATION + 1 random vertices */
+#define ELITE_PERTURBATION (16)
+
+/** A local search restarts after STAGNATION_MIN + STAGNATION_FACTOR * numOfVertices moves without improvement */
+#define STAGNATION_MIN (10000)
+#define STAGNATION_FACTOR (20)
+
+/** Represents a strategy
+ * @brief step advances the search, see searchStep
+ */
+typedef struct strategy {
+  const char *name;
+  int (*step)(searchState *s, int bound);
+} strategy;
+
+static int randomStep(searchState *s, int bound);
+static int minConflictsStep(searchState *s, int bound);
+static int tabuStep(searchState *s, int bound);
+static int exactSearchStep(searchState *s, int bound);
+
+/** The available strategies, indexed by strategyType */
+static const strategy strategies[NUM_STRATEGIES] = {
+  {"random", randomStep},
+  {"minconf", minConflictsStep},
+  {"tabu", tabuStep},
+  {"exact", exactSearchStep}
+};
+
+int parseStrategy(const char *name) {
+  for (int i = 0; i < NUM_STRATEGIES; i++) {
+    if (strcmp(strategies[i].name, name) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+const char *getStrategyName(strategyType type) {
+  return strategies[type].name;
+}
+
+/**
+ * Starts a run of a local search
+ * @brief Recomputes the conflict table of the current coloring and clears the run state
+ * @param s The search state
+*/
+static void startRun(searchState *s) {
+  resetConflictTable(&s->table);
+  s->run_best = s->table.conflicts;
+  s->last_improvement = s->iteration;
+  if (s->tabu_until != NULL) {
+    memset(s->tabu_until, 0, 3 * (size_t) s->g->store.numOfVertices * sizeof(long));
+  }
+}
+
+/**
+ * Crosses two colorings
+ * @brief Greedy partition crossover: color i takes the largest class of parent (first + i) % 2 that is still unassigned,
+ * the vertices left over after three colors get a random one
+ * @details A class is a set of vertices without conflicts among them in a good coloring, so the child inherits the
+ * conflict-free structure of both parents rather than a random mix of their colors
+ * @param s The search state, the child is written to s->colors
+ * @param parents The two parents (numOfVertices colors each)
+ * @param first The parent that gives the first class
+*/
+static void crossColorings(searchState *s, const int *parents[2], int first) {
+  int n = s->g->store.numOfVertices;
+  int left[2][4] = {{0}};
+  for (int v = 0; v < n; v++) {
+    s->colors[v] = 0;
+    left[0][parents[0][v]]++;
+    left[1][parents[1][v]]++;
+  }
+  for (int i = 1; i <= 3; i++) {
+    int p = (first + i - 1) % 2, best = 1;
+    for (int c = 2; c <= 3; c++) {
+      if (left[p][c] > left[p][best]) {
+        best = c;
+      }
+    }
+    for (int v = 0; v < n; v++) {
+      if (s->colors[v] == 0 && parents[p][v] == best) {
+        s->colors[v] = i;
+        left[0][parents[0][v]]--;
+        left[1][parents[1][v]]--;
+      }
+    }
+  }
+  for (int v = 0; v < n; v++) {
+    if (s->colors[v] == 0) {
+      s->colors[v] = nextBounded(s->rng, 3) + 1;
+    }
+  }
+}
+
+/**
+ * Restarts a local search from the elite pool
+ * @brief Crosses two members of the pool, or perturbs one if the pool holds a single member
+ * @param s The search state (with a pool)
+ * @return Returns 1 if s->colors holds the new coloring, 0 if the pool is empty or its members kept changing.
+*/
+static int restartFromElite(searchState *s) {
+  const elitePool *pool = s->pool;
+  int n = s->g->store.numOfVertices;
+  int first = findElite(pool, nextBounded(s->rng, pool->capacity));
+  if (first == -1 || readElite(pool, first, s->parents) == -1) {
+    return 0;
+  }
+  int second = pool->capacity > 1 ? findElite(pool, (first + 1 + nextBounded(s->rng, pool->capacity - 1)) % pool->capacity) : first;
+  if (second != first && readElite(pool, second, s->parents + n) != -1) {
+    const int *parents[2] = {s->parents, s->parents + n};
+    crossColorings(s, parents, nextBounded(s->rng, 2));
+    return 1;
+  }
+  memcpy(s->colors, s->parents, n * sizeof(int));
+  for (int i = n / ELITE_PERTURBATION + 1; i > 0; i--) {
+    s->colors[nextBounded(s->rng, n)] = nextBounded(s->rng, 3) + 1;
+  }
+  return 1;
+}
+
+/**
+ * Restarts a local search
+ * @brief Offers the coloring of the run to the elite pool and draws a new one, a deterministic seed would only repeat
+ * the previous run
+ * @param s The search state
+*/
+static void restartSearch(searchState *s) {
+  if (s->pool != NULL) {
+    offerElite(s->pool, s->colors, s->table.conflicts);
+    if (nextBounded(s->rng, 1024) < ELITE_RESTART && restartFromElite(s)) {
+      startRun(s);
+      return;
+    }
+  }
+  seedColoring(s->seed == SEED_RGREEDY ? SEED_RGREEDY : SEED_RANDOM, s->g, s->rng, s->colors, s->arena);
+  startRun(s);
+}
+
+size_t getSearchBytes(const graph *g, int pooled) {
+  size_t n = g->store.numOfVertices;
+  size_t table = getConflictTableBytes(g);
+  size_t parents = pooled ? getArenaBytes(2 * n * sizeof(int)) : 0;
+  size_t random = getArenaBytes(n * sizeof(int)) + getArenaBytes(g->numOfComponents * sizeof(int))
+                  + getArenaBytes(g->numOfComponents * sizeof(conflictKernel)) + getArenaBytes(n + 3)
+                  + getArenaBytes(g->numOfComponents * sizeof(byteConflictKernel));
+  size_t tabu = table + getArenaBytes(3 * n * sizeof(long)) + parents;
+  size_t exact = table + getExactSearchBytes(n);
+  size_t largest = random > tabu ? random : tabu;
+  largest = largest > exact ? largest : exact;
+  // The seed scratch is taken after the state and released right away
+  return getArenaBytes(n * sizeof(int)) + largest + getSeedBytes(g);
+}
+
+void initSearch(searchState *s, strategyType type, seedType seed, const graph *g, conflictKernel kernel, rng *r,
+                int worker, int num_workers, elitePool *pool, arena *a) {
+  int n = g->store.numOfVertices;
+  memset(s, 0, sizeof(searchState));
+  s->type = type;
+  s->seed = seed;
+  s->g = g;
+  s->kernel = kernel;
+  s->rng = r;
+  s->pool = pool;
+  s->arena = a;
+  s->mark = getArenaMark(a);
+  s->colors = arenaAlloc(a, n * sizeof(int));
+  seedColoring(seed, g, r, s->colors, a);
+  if (type == STRATEGY_RANDOM) {
+    s->candidate = arenaAlloc(a, n * sizeof(int));
+    s->component_cost = arenaAlloc(a, g->numOfComponents * sizeof(int));
+    s->component_kernels = arenaAlloc(a, g->numOfComponents * sizeof(conflictKernel));
+    // The byte kernels gather 4 bytes per vertex
+    s->byte_candidate = arenaAlloc(a, (size_t) n + 3);
+    memset(s->byte_candidate, 0, (size_t) n + 3);
+    s->byte_kernels = arenaAlloc(a, g->numOfComponents * sizeof(byteConflictKernel));
+    // Most components are far smaller than the graph, each gets the kernel of its own size class
+    edgeStore part;
+    for (int k = 0; k < g->numOfComponents; k++) {
+      getComponentStore(g, k, &part);
+      s->component_kernels[k] = selectConflictKernel(&part);
+      s->byte_kernels[k] = selectByteConflictKernel(&part);
+    }
+    return;
+  }
+
+  initConflictTable(&s->table, g, s->colors, a);
+  if (type == STRATEGY_TABU) {
+    s->tabu_until = arenaAlloc(a, 3 * (size_t) n * sizeof(long));
+  }
+  if (pool != NULL && type != STRATEGY_EXACT) {
+    s->parents = arenaAlloc(a, 2 * (size_t) n * sizeof(int));
+  }
+  if (type == STRATEGY_EXACT) {
+    initExactSearch(&s->exact, g, worker, num_workers, a);
+  }
+  startRun(s);
+}
+
+void freeSearch(searchState *s) {
+  resetArena(s->arena, s->mark);
+  memset(s, 0, sizeof(searchState));
+}
+
+int searchStep(searchState *s, int bound) {
+  return strategies[s->type].step(s, bound);
+}
+
+int isSearchExhausted(const searchState *s) {
+  return s->type == STRATEGY_EXACT && isExactExhausted(&s->exact);
+}
+
+void shareSearchColoring(const searchState *s, int cost) {
+  if (s->pool != NULL) {
+    offerElite(s->pool, s->colors, cost);
+  }
+}
+
+int writeSearchSolution(const searchState *s, int bound, edge removed_edges[], int *removed_edges_count) {
+  if (s->type == STRATEGY_RANDOM) {
+    return solveEdgeStoreBounded(s->kernel, &s->g->store, s->colors, bound, removed_edges, removed_edges_count);
+  }
+  return writeConflictEdges(&s->table, bound, removed_edges, removed_edges_count);
+}
+
+int listSearchConflicts(const searchState *s, int bound, int edge_ids[], int *edge_ids_count) {
+  if (s->type == STRATEGY_RANDOM) {
+    return listEdgeStoreConflicts(s->kernel, &s->g->store, s->colors, bound, edge_ids, edge_ids_count);
+  }
+  return listConflictIds(&s->table, bound, edge_ids, edge_ids_count);
+}
+
+/**
+ * Random strategy step
+ * @brief Draws a fresh coloring of every component that still has conflicts and keeps it if it beats the best coloring
+ * of that component, the count of a component stops once it reaches its best cost
+ * @details The components are independent, so colors combines the best coloring of each and the chance of an
+ * improvement is that of the best component, not the product over all of them. The first step evaluates the seed coloring instead
+ * @param s The search state
+ * @param bound The cost to undercut
+ * @return Returns the cost of colors (which may be >= bound).
+*/
+static int randomStep(searchState *s, int bound) {
+  const graph *g = s->g;
+  edgeStore part;
+  int first, total = 0;
+  for (int k = 0; k < g->numOfComponents; k++) {
+    getComponentStore(g, k, &part);
+    int start = g->components[k], size = g->components[k + 1] - start;
+    if (s->iteration == 0) {
+      s->component_cost[k] = s->component_kernels[k](&part, s->colors, INT_MAX, &first);
+    } else if (s->component_cost[k] > 0 && s->byte_kernels[k] != NULL) {
+      // Small components draw and compare 8 bit colors, only an improvement is widened into colors
+      randomizeColorsBytes(s->rng, size, s->byte_candidate + start);
+      int cost = s->byte_kernels[k](&part, s->byte_candidate, s->component_cost[k], &first);
+      if (cost < s->component_cost[k]) {
+        for (int v = start; v < start + size; v++) {
+          s->colors[v] = s->byte_candidate[v];
+        }
+        s->component_cost[k] = cost;
+      }
+    } else if (s->component_cost[k] > 0) {
+      randomizeColors(s->rng, size, s->candidate + start);
+      int cost = s->component_kernels[k](&part, s->candidate, s->component_cost[k], &first);
+      if (cost < s->component_cost[k]) {
+        memcpy(s->colors + start, s->candidate + start, size * sizeof(int));
+        s->component_cost[k] = cost;
+      }
+    }
+    total += s->component_cost[k];
+  }
+  s->iteration++;
+  return total;
+}
+
+/**
+ * Finishes a move
+ * @brief Tracks the best cost of the run and restarts the search if it stagnates
+ * @param s The search state
+*/
+static void finishMove(searchState *s) {
+  s->iteration++;
+  if (s->table.conflicts < s->run_best) {
+    s->run_best = s->table.conflicts;
+    s->last_improvement = s->iteration;
+  } else if (s->iteration - s->last_improvement > STAGNATION_MIN + STAGNATION_FACTOR * (long) s->g->adj.numOfVertices) {
+    restartSearch(s);
+  }
+}
+
+/**
+ * Min-conflicts step
+ * @brief Moves a random vertex of a conflicting edge to the color with the fewest equally colored neighbours
+ * @details Ties are broken randomly, with probability MINCONF_NOISE / 1024 another color is chosen randomly (random walk)
+ * @param s The search state
+ * @param bound The cost to undercut
+ * @return Returns the cost, or a value >= bound.
+*/
+static int minConflictsStep(searchState *s, int bound) {
+  conflictTable *t = &s->table;
+  for (int i = 0; i < LOCAL_SEARCH_BATCH && t->conflicts >= bound; i++) {
+    if (t->conflict_count == 0) {
+      // Only self loops are left, nothing can be improved
+      break;
+    }
+    int v = t->conflict_set[nextBounded(s->rng, t->conflict_count)];
+    int old = s->colors[v], c;
+    if (nextBounded(s->rng, 1024) < MINCONF_NOISE) {
+      c = (old + nextBounded(s->rng, 2)) % 3 + 1;
+    } else {
+      int best = 0, ties = 1;
+      c = old;
+      for (int k = 1; k <= 3; k++) {
+        int delta = getMoveDelta(t, v, k);
+        if (delta < best) {
+          c = k, best = delta, ties = 1;
+        } else if (k != old && delta == best && nextBounded(s->rng, ++ties) == 0) {
+          c = k;
+        }
+      }
+    }
+    applyMove(t, v, c);
+    finishMove(s);
+  }
+  return t->conflicts;
+}
+
+/**
+ * Tabu search step
+ * @brief Makes the best non-tabu move among the vertices of up to TABU_CANDIDATES conflicting vertices
+ * @details A move back to the previous color of a vertex is tabu for 0.6 * conflict_count + rand(TABU_TENURE_RANDOM)
+ * iterations. Tabu moves are allowed if they reach a new best of the run (aspiration).
+ * @param s The search state
+ * @param bound The cost to undercut
+ * @return Returns the cost, or a value >= bound.
+*/
+static int tabuStep(searchState *s, int bound) {
+  conflictTable *t = &s->table;
+  for (int i = 0; i < LOCAL_SEARCH_BATCH && t->conflicts >= bound; i++) {
+    if (t->conflict_count == 0) {
+      break;
+    }
+    int candidates = t->conflict_count < TABU_CANDIDATES ? t->conflict_count : TABU_CANDIDATES;
+    int best_v = -1, best_c = 0, best_delta = 0, ties = 0;
+    for (int j = 0; j < candidates; j++) {
+      int v = candidates == t->conflict_count ? t->conflict_set[j] : t->conflict_set[nextBounded(s->rng, t->conflict_count)];
+      int old = s->colors[v];
+      for (int c = 1; c <= 3; c++) {
+        if (c == old) {
+          continue;
+        }
+        int delta = getMoveDelta(t, v, c);
+        int tabu = s->tabu_until[3 * v + c - 1] > s->iteration;
+        if (tabu && t->conflicts + delta >= s->run_best) {
+          continue;
+        }
+        if (best_v == -1 || delta < best_delta) {
+          best_v = v, best_c = c, best_delta = delta, ties = 1;
+        } else if (delta == best_delta && nextBounded(s->rng, ++ties) == 0) {
+          best_v = v, best_c = c;
+        }
+      }
+    }
+    if (best_v == -1) {
+      // Every candidate move is tabu
+      best_v = t->conflict_set[nextBounded(s->rng, t->conflict_count)];
+      best_c = (s->colors[best_v] + nextBounded(s->rng, 2)) % 3 + 1;
+    }
+    int old = s->colors[best_v];
+    applyMove(t, best_v, best_c);
+    s->tabu_until[3 * best_v + old - 1] = s->iteration + (6 * t->conflict_count) / 10 + nextBounded(s->rng, TABU_TENURE_RANDOM);
+    finishMove(s);
+  }
+  return t->conflicts;
+}
+
+/**
+ * Exact strategy step
+ * @brief Advances the branch-and-bound search, a coloring it finds replaces the current one
+ * @param s The search state
+ * @param bound The cost to undercut
+ * @return Returns the cost, or a value >= bound.
+*/
+static int exactSearchStep(searchState *s, int bound) {
+  int cost = exactStep(&s->exact, bound, EXACT_BATCH, s->colors);
+  if (cost < bound) {
+    resetConflictTable(&s->table);
+  }
+  return cost;
+}
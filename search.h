@@ -0,0 +1,174 @@
+/**
+ * @file search.h
+ * @author Giancarlo Buenaflor <e51837398@tuwien.ac.at>
+ * @date 18.11.2020
+ *
+ * @brief Provides the search strategies of the generator.
+ *
+ * The search module. A strategy turns the current coloring of a worker into the next candidate: "random" draws a
+ * fresh coloring of every connected component each step and keeps the best coloring found for each component, "minconf" and "tabu" repeatedly recolor a vertex of a conflicting edge, evaluating every
+ * move in O(1) with a conflictTable. Every search starts from a seed coloring (see seed.h), the local searches restart
+ * from a random coloring if they stagnate (from a new rgreedy coloring if that is the seed), or with an elite pool
+ * mostly from a perturbed member or the crossover of two members of the pool (see elite.h). "exact" runs a
+ * branch-and-bound search (see exact.h) that ends once it has proven that no better coloring exists.
+ */
+
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "graph.h"
+#include "kernel.h"
+#include "random.h"
+#include "conflict.h"
+#include "seed.h"
+#include "exact.h"
+#include "elite.h"
+
+/** Represents the available search strategies */
+typedef enum strategyType {
+  STRATEGY_RANDOM = 0,
+  STRATEGY_MINCONF,
+  STRATEGY_TABU,
+  STRATEGY_EXACT,
+  NUM_STRATEGIES
+} strategyType;
+
+/** Represents the search state of one worker
+ * @brief colors is the current coloring (1 to 3 per vertex), table tracks its conflicts (local search only)
+ * tabu_until[3 * v + c - 1] is the first iteration in which v may get color c again (tabu only).
+ * run_best is the best cost since the last restart, reached in iteration last_improvement.
+ * exact is the branch-and-bound state (exact only), colors then holds the last coloring it found.
+ * candidate is the coloring drawn by the random strategy, component_cost[k] the cost of component k in colors and
+ * component_kernels[k] the kernel selected for its size class (random only). Components of at most 64 edges are drawn
+ * into byte_candidate instead and counted with byte_kernels[k] (NULL for larger components).
+ * pool is the elite pool the search shares its colorings through (NULL for none), parents holds the two colorings a
+ * restart reads from it (local search with a pool only).
+ * All arrays are taken from arena, from mark on.
+ */
+typedef struct searchState {
+  strategyType type;
+  seedType seed;
+  const graph *g;
+  conflictKernel kernel;
+  rng *rng;
+  int *colors;
+  conflictTable table;
+  long *tabu_until;
+  long iteration;
+  long last_improvement;
+  int run_best;
+  exactSearch exact;
+  int *candidate;
+  int *component_cost;
+  conflictKernel *component_kernels;
+  uint8_t *byte_candidate;
+  byteConflictKernel *byte_kernels;
+  elitePool *pool;
+  int *parents;
+  arena *arena;
+  size_t mark;
+} searchState;
+
+/**
+ * Looks up a strategy by name
+ * @param name The name ("random", "minconf", "tabu" or "exact")
+ * @return Returns the strategy, or -1 if the name is unknown.
+*/
+int parseStrategy(const char *name);
+
+/**
+ * Name of a strategy
+ * @param type The strategy
+ * @return Returns the name of the strategy.
+*/
+const char *getStrategyName(strategyType type);
+
+/**
+ * Arena size of a search
+ * @brief The largest state of any strategy plus the scratch of the seeds, so a worker can switch strategies in the
+ * same arena
+ * @param g The graph
+ * @param pooled 1 if the search has an elite pool, 0 otherwise
+ * @return Returns the number of arena bytes initSearch and the search steps may take.
+*/
+size_t getSearchBytes(const graph *g, int pooled);
+
+/**
+ * Initializes a search
+ * @brief Allocates the state for the strategy from the arena and starts from a seed coloring
+ * @details The random strategy evaluates the seed coloring in its first step. The exact strategy searches the part
+ * worker of num_workers of its tree, the other strategies ignore both. Searching never allocates
+ * @param s The search state
+ * @param type The strategy
+ * @param seed The initial coloring
+ * @param g The graph (must outlive the search)
+ * @param kernel The conflict kernel selected for the whole graph, used to write and list the solutions of the random strategy
+ * @param r The random number generator of the worker
+ * @param worker The index of the worker
+ * @param num_workers The number of workers running the same search
+ * @param pool The elite pool of the graph, or NULL
+ * @param a The arena of the worker (getSearchBytes free)
+*/
+void initSearch(searchState *s, strategyType type, seedType seed, const graph *g, conflictKernel kernel, rng *r,
+                int worker, int num_workers, elitePool *pool, arena *a);
+
+/**
+ * Frees a search
+ * @brief Releases the arena back to where the search started
+ * @param s The search state
+*/
+void freeSearch(searchState *s);
+
+/**
+ * Advances the search
+ * @brief Runs the strategy until the coloring costs less than bound, or for a bounded amount of work
+ * @details The random strategy draws one coloring, the local search strategies make up to a few hundred moves, the
+ * exact strategy visits up to a few thousand nodes. The bound may only decrease between calls of the exact strategy.
+ * A result >= bound may be larger than the real cost of s->colors.
+ * @param s The search state
+ * @param bound The cost a coloring must undercut to be returned early
+ * @return Returns the cost of s->colors if it is below bound, otherwise a value >= bound.
+*/
+int searchStep(searchState *s, int bound);
+
+/**
+ * Tells whether a search has proven its bound
+ * @brief Only the exact strategy ends: once exhausted, no coloring of its part of the tree costs less than the bound
+ * of the last searchStep
+ * @param s The search state
+ * @return Returns 1 if the search is exhausted, 0 otherwise.
+*/
+int isSearchExhausted(const searchState *s);
+
+/**
+ * Shares the current coloring
+ * @brief Offers s->colors to the elite pool of the search, see offerElite
+ * @param s The search state
+ * @param cost The cost of s->colors
+*/
+void shareSearchColoring(const searchState *s, int cost);
+
+/**
+ * Writes the removed edges of the current coloring
+ * @brief Local searches list the edges from their conflict table, the random strategy rescans the edges with the kernel
+ * @details Nothing is written if more than bound edges conflict. The ids are those of the graph, not mapped back to the input.
+ * @param s The search state
+ * @param bound The maximum number of removed edges that is still accepted
+ * @param removed_edges The removed_edges array that will be filled (at least bound entries)
+ * @param removed_edges_count The count for removed_edges (pointer, only set if the coloring is accepted)
+ * @return Returns 1 if at most bound edges conflict, 0 otherwise.
+*/
+int writeSearchSolution(const searchState *s, int bound, edge removed_edges[], int *removed_edges_count);
+
+/**
+ * Lists the indices of the removed edges of the current coloring
+ * @brief Like writeSearchSolution, but writes the index of every removed edge in the edge store (not sorted)
+ * @param s The search state
+ * @param bound The maximum number of removed edges that is still accepted
+ * @param edge_ids The array that will be filled (at least bound entries)
+ * @param edge_ids_count The count for edge_ids (pointer, only set if the coloring is accepted)
+ * @return Returns 1 if at most bound edges conflict, 0 otherwise.
+*/
+int listSearchConflicts(const searchState *s, int bound, int edge_ids[], int *edge_ids_count);
+
+#endif
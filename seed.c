@@ -0,0 +1,246 @@
+/**
+ * @file seed.c
+ * @author Giancarlo Buenaflor <e51837398@tuwien.ac.at>
+ * @date 18.11.2020
+ *
+ * @brief Implementation of the seed module.
+ *
+ **/
+
+#include "seed.h"
+
+/** The names of the seeds, indexed by seedType */
+static const char *seed_names[NUM_SEEDS] = {"random", "greedy", "rgreedy", "dsatur"};
+
+/** Represents a dsatur heap entry
+ * @brief saturation and degree are the key of v when it was pushed, entries with an outdated saturation are skipped
+ */
+typedef struct saturationEntry {
+  int saturation;
+  int degree;
+  int v;
+} saturationEntry;
+
+int parseSeed(const char *name) {
+  for (int i = 0; i < NUM_SEEDS; i++) {
+    if (strcmp(seed_names[i], name) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+const char *getSeedName(seedType type) {
+  return seed_names[type];
+}
+
+/**
+ * Picks the color of a vertex
+ * @brief Chooses the color held by the fewest colored neighbours
+ * @param counts The number of colored neighbours per color (3 entries)
+ * @param r Breaks ties randomly if not NULL, otherwise the smallest color wins
+ * @return Returns the color (1 to 3).
+*/
+static int pickColor(const int counts[], rng *r) {
+  int best = 1, ties = 1;
+  for (int c = 2; c <= 3; c++) {
+    if (counts[c - 1] < counts[best - 1]) {
+      best = c, ties = 1;
+    } else if (r != NULL && counts[c - 1] == counts[best - 1] && nextBounded(r, ++ties) == 0) {
+      best = c;
+    }
+  }
+  return best;
+}
+
+/**
+ * Colors a vertex
+ * @brief Sets the color of v and counts it at every neighbour
+ * @param adj The adjacency of the graph
+ * @param counts The number of colored neighbours per vertex and color (3 * numOfVertices entries)
+ * @param colors The coloring
+ * @param v The vertex
+ * @param c The color
+*/
+static void colorVertex(const adjacency *adj, int counts[], int colors[], int v, int c) {
+  colors[v] = c;
+  for (int k = adj->offsets[v]; k < adj->offsets[v + 1]; k++) {
+    counts[3 * adj->neighbors[k] + c - 1]++;
+  }
+}
+
+/**
+ * Greedy coloring
+ * @brief Colors the vertices by decreasing degree, with rng the degree of each vertex is raised by up to half of itself
+ * @details The order is a stable counting sort, with rng it is applied to a random permutation so equal keys are shuffled
+ * @param adj The adjacency of the graph
+ * @param r The random number generator, or NULL for the deterministic greedy coloring
+ * @param colors The coloring
+ * @param scratch The arena the working arrays are taken from
+*/
+static void greedyColoring(const adjacency *adj, rng *r, int colors[], arena *scratch) {
+  int n = adj->numOfVertices, max_key = 0;
+  int *keys = arenaAlloc(scratch, n * sizeof(int));
+  int *order = arenaAlloc(scratch, n * sizeof(int));
+  for (int v = 0; v < n; v++) {
+    int degree = getDegree(adj, v);
+    keys[v] = r != NULL ? degree + (int) nextBounded(r, degree / 2 + 1) : degree;
+    max_key = keys[v] > max_key ? keys[v] : max_key;
+    order[v] = v;
+  }
+  if (r != NULL) {
+    for (int i = n - 1; i > 0; i--) {
+      int j = nextBounded(r, i + 1), tmp = order[i];
+      order[i] = order[j];
+      order[j] = tmp;
+    }
+  }
+
+  // Bucket start positions, largest key first
+  int *start = arenaAlloc(scratch, (max_key + 2) * sizeof(int));
+  int *sorted = arenaAlloc(scratch, n * sizeof(int));
+  for (int v = 0; v < n; v++) {
+    start[max_key - keys[v] + 1]++;
+  }
+  for (int k = 0; k <= max_key; k++) {
+    start[k + 1] += start[k];
+  }
+  for (int i = 0; i < n; i++) {
+    int v = order[i];
+    sorted[start[max_key - keys[v]]++] = v;
+  }
+
+  int *counts = arenaAlloc(scratch, 3 * (size_t) n * sizeof(int));
+  for (int i = 0; i < n; i++) {
+    int v = sorted[i];
+    colorVertex(adj, counts, colors, v, pickColor(&counts[3 * v], r));
+  }
+}
+
+/**
+ * Compares two dsatur heap entries
+ * @return Returns 1 if a should be colored before b.
+*/
+static int saturationBefore(const saturationEntry *a, const saturationEntry *b) {
+  if (a->saturation != b->saturation) {
+    return a->saturation > b->saturation;
+  }
+  if (a->degree != b->degree) {
+    return a->degree > b->degree;
+  }
+  return a->v < b->v;
+}
+
+/**
+ * Pushes a dsatur heap entry
+ * @param heap The binary max heap (room for one more entry)
+ * @param size The number of entries (pointer, incremented)
+ * @param entry The new entry
+*/
+static void pushSaturation(saturationEntry heap[], int *size, saturationEntry entry) {
+  int i = (*size)++;
+  while (i > 0 && saturationBefore(&entry, &heap[(i - 1) / 2])) {
+    heap[i] = heap[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  heap[i] = entry;
+}
+
+/**
+ * Pops the first dsatur heap entry
+ * @param heap The binary max heap (not empty)
+ * @param size The number of entries (pointer, decremented)
+ * @return Returns the removed entry.
+*/
+static saturationEntry popSaturation(saturationEntry heap[], int *size) {
+  saturationEntry top = heap[0], last = heap[--(*size)];
+  int i = 0;
+  for (;;) {
+    int child = 2 * i + 1;
+    if (child >= *size) {
+      break;
+    }
+    if (child + 1 < *size && saturationBefore(&heap[child + 1], &heap[child])) {
+      child++;
+    }
+    if (!saturationBefore(&heap[child], &last)) {
+      break;
+    }
+    heap[i] = heap[child];
+    i = child;
+  }
+  heap[i] = last;
+  return top;
+}
+
+/**
+ * DSatur coloring
+ * @brief Repeatedly colors the uncolored vertex with the most distinct neighbour colors, ties by degree and id
+ * @details The saturation of a vertex only grows, at most 3 times, so every change pushes a new heap entry and outdated
+ * entries are skipped when popped. This keeps the heap below 4 * numOfVertices entries and the run in O(E + V log V)
+ * @param adj The adjacency of the graph
+ * @param colors The coloring
+ * @param scratch The arena the working arrays are taken from
+*/
+static void dsaturColoring(const adjacency *adj, int colors[], arena *scratch) {
+  int n = adj->numOfVertices, size = 0;
+  int *counts = arenaAlloc(scratch, 3 * (size_t) n * sizeof(int));
+  int *saturation = arenaAlloc(scratch, n * sizeof(int));
+  saturationEntry *heap = arenaAlloc(scratch, 4 * (size_t) n * sizeof(saturationEntry));
+  for (int v = 0; v < n; v++) {
+    colors[v] = 0;
+    pushSaturation(heap, &size, (saturationEntry) {0, getDegree(adj, v), v});
+  }
+
+  while (size > 0) {
+    saturationEntry entry = popSaturation(heap, &size);
+    int v = entry.v;
+    if (colors[v] != 0 || entry.saturation != saturation[v]) {
+      continue;
+    }
+    int c = pickColor(&counts[3 * v], NULL);
+    // Like colorVertex, but the count is checked per edge: parallel edges list u several times, only the first time
+    // u sees color c raises its saturation
+    colors[v] = c;
+    for (int k = adj->offsets[v]; k < adj->offsets[v + 1]; k++) {
+      int u = adj->neighbors[k];
+      if (counts[3 * u + c - 1]++ == 0 && colors[u] == 0) {
+        saturation[u]++;
+        pushSaturation(heap, &size, (saturationEntry) {saturation[u], getDegree(adj, u), u});
+      }
+    }
+  }
+}
+
+size_t getSeedBytes(const graph *g) {
+  const adjacency *adj = &g->adj;
+  size_t n = adj->numOfVertices;
+  int max_degree = 0;
+  for (int v = 0; v < adj->numOfVertices; v++) {
+    max_degree = getDegree(adj, v) > max_degree ? getDegree(adj, v) : max_degree;
+  }
+  // A key of rgreedy is at most 1.5 times the degree
+  size_t greedy = 3 * getArenaBytes(n * sizeof(int)) + getArenaBytes((max_degree + max_degree / 2 + 2) * sizeof(int))
+                  + getArenaBytes(3 * n * sizeof(int));
+  size_t dsatur = getArenaBytes(3 * n * sizeof(int)) + getArenaBytes(n * sizeof(int))
+                  + getArenaBytes(4 * n * sizeof(saturationEntry));
+  return greedy > dsatur ? greedy : dsatur;
+}
+
+void seedColoring(seedType type, const graph *g, rng *r, int colors[], arena *scratch) {
+  size_t mark = getArenaMark(scratch);
+  switch (type) {
+    case SEED_GREEDY:
+      greedyColoring(&g->adj, NULL, colors, scratch);
+      break;
+    case SEED_RGREEDY:
+      greedyColoring(&g->adj, r, colors, scratch);
+      break;
+    case SEED_DSATUR:
+      dsaturColoring(&g->adj, colors, scratch);
+      break;
+    default:
+      randomizeColors(r, g->store.numOfVertices, colors);
+  }
+  resetArena(scratch, mark);
+}
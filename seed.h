@@ -0,0 +1,64 @@
+/**
+ * @file seed.h
+ * @author Giancarlo Buenaflor <e51837398@tuwien.ac.at>
+ * @date 18.11.2020
+ *
+ * @brief Provides the initial colorings of the searches.
+ *
+ * The seed module. Besides a uniformly random coloring, a search can start from a greedy coloring: "greedy" colors the
+ * vertices by decreasing degree, "rgreedy" does the same with random noise on the degrees and random tie-breaking for
+ * diversity, and "dsatur" always colors the vertex with the most distinct colors among its colored neighbours next.
+ * Each vertex gets the color shared by the fewest of its colored neighbours. All seeds take O(E log V) at most.
+ */
+
+#ifndef SEED_H
+#define SEED_H
+
+#include "graph.h"
+#include "random.h"
+#include "arena.h"
+
+/** Represents the available initial colorings */
+typedef enum seedType {
+  SEED_RANDOM = 0,
+  SEED_GREEDY,
+  SEED_RGREEDY,
+  SEED_DSATUR,
+  NUM_SEEDS
+} seedType;
+
+/**
+ * Looks up a seed by name
+ * @param name The name ("random", "greedy", "rgreedy" or "dsatur")
+ * @return Returns the seed, or -1 if the name is unknown.
+*/
+int parseSeed(const char *name);
+
+/**
+ * Name of a seed
+ * @param type The seed
+ * @return Returns the name of the seed.
+*/
+const char *getSeedName(seedType type);
+
+/**
+ * Creates an initial coloring
+ * @brief Fills colors with a coloring of the given type (1 to 3 per vertex)
+ * @details greedy and dsatur are deterministic, random and rgreedy draw from r. The scratch memory is taken from the
+ * arena and released again before the function returns
+ * @param type The seed
+ * @param g The graph
+ * @param r The random number generator of the worker
+ * @param colors The coloring (g->store.numOfVertices entries)
+ * @param scratch The arena of the worker (getSeedBytes(g) bytes free)
+*/
+void seedColoring(seedType type, const graph *g, rng *r, int colors[], arena *scratch);
+
+/**
+ * Arena size of the seeds
+ * @param g The graph
+ * @return Returns the number of arena bytes seedColoring needs for any seed.
+*/
+size_t getSeedBytes(const graph *g);
+
+#endif
@@ -7,45 +7,83 @@
  *
  **/
 
+#include <limits.h>
+#include <errno.h>
+#include <ctype.h>
+#include <time.h>
+#include <signal.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
 #include "sharedmem.h"
+#include "random.h"
 
 char *pgm_name;
 
-void closeSemaphores(sem_t *used_sem, sem_t *free_sem, sem_t *mutex_sem) {
+/** The names of the wait policies, indexed by waitPolicy */
+static const char *wait_policy_names[NUM_WAIT_POLICIES] = {"spin", "adaptive", "block"};
+
+void closeSemaphores(sem_t *used_sem) {
   if (sem_close(used_sem) == -1) {
 		printErrAndExit("Closing used_sum failed");
 	}
-  if (sem_close(free_sem) == -1) {
-		printErrAndExit("Closing free_sem failed");
-	}
-  if (sem_close(mutex_sem) == -1) {
-		printErrAndExit("Closing mutex_sem failed");
-	}
 }
 
 void unmapSHM(myshm *myshm) {
-  if (munmap(myshm, sizeof(myshm)) == -1) {
+  if (munmap(myshm, myshm->shm_size) == -1) {
 		printErrAndExit("Unmapping SHM failed");
 	}
 }
 
-void unlinkRessources() {
-  if (sem_unlink(USED_SEM) == -1) {
+int initJobNames(jobNames *names, const char *job) {
+  if (job == NULL) {
+    strcpy(names->shm, SHM_NAME);
+    strcpy(names->graph, SHM_GRAPH_NAME);
+    strcpy(names->elite, SHM_ELITE_NAME);
+    strcpy(names->used_sem, USED_SEM);
+    return 0;
+  }
+  size_t length = strlen(job);
+  if (length == 0 || length > MAX_JOB_NAME) {
+    return -1;
+  }
+  for (size_t i = 0; i < length; i++) {
+    if (!isalnum((unsigned char) job[i]) && job[i] != '-' && job[i] != '_') {
+      return -1;
+    }
+  }
+  snprintf(names->shm, MAX_OBJECT_NAME, "%s_%s", SHM_NAME, job);
+  snprintf(names->graph, MAX_OBJECT_NAME, "%s_%s", SHM_GRAPH_NAME, job);
+  snprintf(names->elite, MAX_OBJECT_NAME, "%s_%s", SHM_ELITE_NAME, job);
+  snprintf(names->used_sem, MAX_OBJECT_NAME, "%s_%s", USED_SEM, job);
+  return 0;
+}
+
+void unlinkRessources(const jobNames *names) {
+  if (sem_unlink(names->used_sem) == -1) {
 		printErrAndExit("Unlinking USED_SEM failed");
 	}
-  if (sem_unlink(FREE_SEM) == -1) {
-		printErrAndExit("Unlinking FREE_SEM failed");
-	}
-	if (sem_unlink(MUTEX_SEM) == -1) {
-		printErrAndExit("Unlinking FREE_SEM failed");
-	}
-  if (shm_unlink(SHM_NAME) == -1) {
+  if (shm_unlink(names->shm) == -1) {
 		printErrAndExit("Unlinking SHM object failed");
   }
+  // The graph segment only exists if a graph was shared
+  if (shm_unlink(names->graph) == -1 && errno != ENOENT) {
+		printErrAndExit("Unlinking SHM graph object failed");
+  }
+  // The elite pool only exists if a generator mapped the shared graph
+  if (shm_unlink(names->elite) == -1 && errno != ENOENT) {
+		printErrAndExit("Unlinking SHM elite object failed");
+  }
 }
 
 myshm* createMappedSHMObject(int shmfd) {
-  myshm *myshm = mmap(NULL, sizeof(myshm), PROT_READ | PROT_WRITE, MAP_SHARED, shmfd, 0);
+  struct stat st;
+  if (fstat(shmfd, &st) == -1) {
+		printErrAndExit("Stat SHM failed");
+	}
+  if ((size_t) st.st_size < sizeof(struct myshm)) {
+		printErrAndExit("SHM is not initialized");
+	}
+  myshm *myshm = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, shmfd, 0);
   if (myshm == MAP_FAILED) {
 		printErrAndExit("Mapping SHM failed");
 	}
@@ -55,31 +93,327 @@ myshm* createMappedSHMObject(int shmfd) {
   return myshm;
 }
 
-int createSHMFileDescriptor() {
-	int shmfd = shm_open(SHM_NAME, O_RDWR | O_CREAT, 0600);
+size_t getSHMSize(unsigned long capacity, int max_edges) {
+  size_t slot_size = sizeof(removedEdge) + max_edges * sizeof(edge);
+  slot_size = (slot_size + sizeof(unsigned long) - 1) & ~(sizeof(unsigned long) - 1);
+  return sizeof(struct myshm) + capacity * slot_size;
+}
+
+int createSHMFileDescriptor(const jobNames *names, size_t size) {
+	int shmfd = shm_open(names->shm, O_RDWR | O_CREAT, 0600);
 	if (shmfd == -1) { 
 		printErrAndExit("SHM_NAME failed creation");
 	}
 
-	if (ftruncate(shmfd, sizeof(struct myshm)) < 0) {
+	if (ftruncate(shmfd, size) < 0) {
 		printErrAndExit("Truncate SHM failed");
 	}
 	return shmfd;
 }
 
-int openSHMFileDescriptor() {
-  int shmfd = shm_open(SHM_NAME, O_RDWR, 0600);
+int openSHMFileDescriptor(const jobNames *names) {
+  int shmfd = shm_open(names->shm, O_RDWR, 0600);
 	if (shmfd == -1) { 
 		printErrAndExit("Couldn't open shmf");
 	}
   return shmfd;
 }
 
-void randomizeColors(int numOfVertices, int *color_indices) {
-  for (int v = 0; v < numOfVertices; v++) {
-    int random_num = 1 + (rand() % 3);
-    color_indices[v] = random_num;
+void initializeRing(myshm *myshm, unsigned long capacity, int max_edges) {
+  myshm->capacity = capacity;
+  myshm->max_edges = max_edges;
+  myshm->best_solution = INT_MAX;
+  myshm->optimal = -1;
+  myshm->shm_size = getSHMSize(capacity, max_edges);
+  myshm->slot_size = (myshm->shm_size - sizeof(struct myshm)) / capacity;
+  for (unsigned long i = 0; i < capacity; i++) {
+    __atomic_store_n(&getSlot(myshm, i)->sequence, i, __ATOMIC_RELAXED);
+  }
+  __atomic_store_n(&myshm->head, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&myshm->tail, 0, __ATOMIC_RELAXED);
+  memset(myshm->generators, 0, sizeof(myshm->generators));
+  memset(&myshm->supervisor, 0, sizeof(myshm->supervisor));
+  __atomic_store_n(&myshm->sleeping, 0, __ATOMIC_RELEASE);
+}
+
+int ringReserve(myshm *myshm, int count, unsigned long *pos) {
+  unsigned long first = __atomic_load_n(&myshm->head, __ATOMIC_RELAXED);
+  for (;;) {
+    unsigned long last = first + count - 1;
+    unsigned long seq = __atomic_load_n(&getSlot(myshm, last)->sequence, __ATOMIC_ACQUIRE);
+    long diff = (long) (seq - last);
+    if (diff == 0) {
+      // The last cell is free, so are all before it. On failure first is reloaded with the current head.
+      if (__atomic_compare_exchange_n(&myshm->head, &first, first + count, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        *pos = first;
+        return 0;
+      }
+    } else if (diff < 0) {
+      // The cell still holds a solution from the previous lap, the buffer is too full
+      return -1;
+    } else {
+      first = __atomic_load_n(&myshm->head, __ATOMIC_RELAXED);
+    }
+  }
+}
+
+void ringPublish(myshm *myshm, unsigned long pos, int count) {
+  removedEdge *slot = getSlot(myshm, pos);
+  slot->batch = count;
+  __atomic_store_n(&slot->sequence, pos + 1, __ATOMIC_RELEASE);
+}
+
+int ringPush(myshm *myshm, int numOfEdges, edge removed_edges[]) {
+  unsigned long pos;
+  if (ringReserve(myshm, 1, &pos) == -1) {
+    return -1;
+  }
+  removedEdge *slot = getSlot(myshm, pos);
+  slot->numOfEdges = numOfEdges;
+  slot->format = SOLUTION_EDGES;
+  slot->size = numOfEdges * sizeof(edge);
+  slot->generator = 0;
+  memcpy(slot->edges, removed_edges, numOfEdges * sizeof(edge));
+  ringPublish(myshm, pos, 1);
+  return 0;
+}
+
+unsigned long ringAvailable(myshm *myshm) {
+  unsigned long pos = __atomic_load_n(&myshm->tail, __ATOMIC_RELAXED), count = 0;
+  while (count < myshm->capacity) {
+    removedEdge *slot = getSlot(myshm, pos + count);
+    if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != pos + count + 1) {
+      break;
+    }
+    count += slot->batch;
+  }
+  return count;
+}
+
+void ringRelease(myshm *myshm, unsigned long count) {
+  unsigned long pos = __atomic_load_n(&myshm->tail, __ATOMIC_RELAXED);
+  for (unsigned long i = 0; i < count; i++) {
+    __atomic_store_n(&getSlot(myshm, pos + i)->sequence, pos + i + myshm->capacity, __ATOMIC_RELEASE);
+  }
+  __atomic_store_n(&myshm->tail, pos + count, __ATOMIC_RELAXED);
+}
+
+/**
+ * Calls the futex system call
+ * @brief The futex is shared between processes, so the private flag must not be used
+ * @param addr The futex word
+ * @param op FUTEX_WAIT or FUTEX_WAKE
+ * @param val The expected value (FUTEX_WAIT) or the number of waiters to wake (FUTEX_WAKE)
+ * @return Returns the result of the system call.
+*/
+static long futex(int *addr, int op, int val) {
+  return syscall(SYS_futex, addr, op, val, NULL, NULL, 0);
+}
+
+/**
+ * Hints the cpu that the caller is spinning
+*/
+static inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  __asm__ __volatile__("yield");
+#endif
+}
+
+void ringWakeConsumer(myshm *myshm) {
+  // Orders the publishing store before the load of sleeping (pairs with the fence in ringWaitConsumer)
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&myshm->sleeping, __ATOMIC_RELAXED) == 0) {
+    return;
+  }
+  if (__atomic_exchange_n(&myshm->sleeping, 0, __ATOMIC_ACQ_REL) == 1) {
+    futex(&myshm->sleeping, FUTEX_WAKE, 1);
+  }
+}
+
+int parseWaitPolicy(const char *name) {
+  for (int i = 0; i < NUM_WAIT_POLICIES; i++) {
+    if (strcmp(wait_policy_names[i], name) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/**
+ * Checks the buffers
+ * @param rings The mapped shared memory objects
+ * @param count The number of buffers
+ * @return Returns 1 if any buffer is non-empty, 0 otherwise.
+*/
+static int anyAvailable(myshm *rings[], int count) {
+  for (int i = 0; i < count; i++) {
+    if (ringAvailable(rings[i]) != 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Sleeps until a producer clears one of the sleeping flags
+ * @param rings The mapped shared memory objects (sleeping set to 1)
+ * @param count The number of buffers
+ * @param timeout_ms The longest time to sleep in milliseconds, -1 for no limit
+ * @return Returns the result of the system call.
+*/
+static long sleepOnRings(myshm *rings[], int count, long timeout_ms) {
+  struct timespec relative = {timeout_ms / 1000, (timeout_ms % 1000) * 1000000};
+  if (count == 1) {
+    return syscall(SYS_futex, &rings[0]->sleeping, FUTEX_WAIT, 1, timeout_ms >= 0 ? &relative : NULL, NULL, 0);
+  }
+#ifdef SYS_futex_waitv
+  struct futex_waitv waiters[MAX_JOBS];
+  for (int i = 0; i < count; i++) {
+    waiters[i] = (struct futex_waitv) {
+      .val = 1,
+      .uaddr = (uintptr_t) &rings[i]->sleeping,
+      .flags = FUTEX_32
+    };
+  }
+  // futex_waitv takes an absolute timeout
+  struct timespec absolute;
+  clock_gettime(CLOCK_MONOTONIC, &absolute);
+  absolute.tv_sec += relative.tv_sec + (absolute.tv_nsec + relative.tv_nsec) / 1000000000;
+  absolute.tv_nsec = (absolute.tv_nsec + relative.tv_nsec) % 1000000000;
+  long result = syscall(SYS_futex_waitv, waiters, count, 0, timeout_ms >= 0 ? &absolute : NULL, CLOCK_MONOTONIC);
+  if (result != -1 || errno != ENOSYS) {
+    return result;
   }
+#endif
+  // Older kernels, the other buffers are checked at least every millisecond
+  struct timespec timeout = {0, timeout_ms == 0 ? 0 : 1000000};
+  return syscall(SYS_futex, &rings[0]->sleeping, FUTEX_WAIT, 1, &timeout, NULL, 0);
+}
+
+int ringWaitConsumer(myshm *rings[], int count, waitPolicy policy, long timeout_ms) {
+  if (policy != WAIT_BLOCK) {
+    for (int i = 0; i < WAIT_SPIN_ROUNDS; i++) {
+      if (anyAvailable(rings, count)) {
+        return 0;
+      }
+      cpuRelax();
+    }
+    if (policy == WAIT_SPIN) {
+      return 0;
+    }
+  }
+
+  for (int i = 0; i < count; i++) {
+    __atomic_store_n(&rings[i]->sleeping, 1, __ATOMIC_RELAXED);
+  }
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  int result = 0;
+  if (!anyAvailable(rings, count)) {
+    // Returns at once if a producer cleared a flag in between
+    if (sleepOnRings(rings, count, timeout_ms) == -1 && errno == EINTR) {
+      result = -1;
+    }
+  }
+  // A producer that took a flag in between only wakes no waiter
+  for (int i = 0; i < count; i++) {
+    __atomic_store_n(&rings[i]->sleeping, 0, __ATOMIC_RELAXED);
+  }
+  return result;
+}
+
+unsigned long getMonotonicMillis(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (unsigned long) now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+unsigned long getMonotonicNanos(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (unsigned long) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+generatorEntry *registerGenerator(myshm *myshm, int pid, int running) {
+  for (int i = 0; i < MAX_GENERATORS; i++) {
+    generatorEntry *entry = &myshm->generators[i];
+    int expected = 0;
+    if (__atomic_compare_exchange_n(&entry->pid, &expected, pid, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+      memset(&entry->counters, 0, sizeof(entry->counters));
+      __atomic_store_n(&entry->running, running, __ATOMIC_RELAXED);
+      __atomic_store_n(&entry->assigned, NO_ASSIGNMENT, __ATOMIC_RELAXED);
+      // The supervisor only reads or assigns entries with a heartbeat
+      __atomic_store_n(&entry->heartbeat, getMonotonicMillis(), __ATOMIC_RELEASE);
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+void reportGenerator(generatorEntry *entry, generatorCounters *delta) {
+  if (entry != NULL) {
+    __atomic_add_fetch(&entry->counters.attempts, delta->attempts, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&entry->counters.submitted, delta->submitted, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&entry->counters.rejected, delta->rejected, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&entry->counters.solve_ns, delta->solve_ns, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&entry->counters.blocked_ns, delta->blocked_ns, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->heartbeat, getMonotonicMillis(), __ATOMIC_RELEASE);
+  }
+  memset(delta, 0, sizeof(*delta));
+}
+
+/**
+ * Frees a registry entry
+ * @brief Marks it ENTRY_RELEASING with a compare-and-swap, clears its heartbeat and frees it
+ * @details registerGenerator only takes free entries, so nobody writes the entry in between
+ * @param entry The entry
+ * @param pid The pid the entry must still hold
+ * @return Returns 1 if the entry was freed, 0 if it doesn't hold pid (anymore).
+*/
+static int releaseEntry(generatorEntry *entry, int pid) {
+  if (!__atomic_compare_exchange_n(&entry->pid, &pid, ENTRY_RELEASING, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+    return 0;
+  }
+  // A heartbeat of 0 marks an entry that is being taken, the supervisor skips it until the new owner reports
+  __atomic_store_n(&entry->heartbeat, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&entry->pid, 0, __ATOMIC_RELEASE);
+  return 1;
+}
+
+void unregisterGenerator(generatorEntry *entry, int pid) {
+  // The entry may have been reaped and taken by another generator meanwhile
+  if (entry != NULL) {
+    releaseEntry(entry, pid);
+  }
+}
+
+int reapGenerators(myshm *myshm, int reaped[]) {
+  int count = 0;
+  for (int i = 0; i < MAX_GENERATORS; i++) {
+    generatorEntry *entry = &myshm->generators[i];
+    int pid = __atomic_load_n(&entry->pid, __ATOMIC_ACQUIRE);
+    // A live generator is never reaped, however long its search steps or a full buffer delay its heartbeat
+    if (pid <= 0 || kill(pid, 0) == 0 || errno != ESRCH) {
+      continue;
+    }
+    // Fails if the generator unregistered itself (and the entry was taken again) in between
+    if (releaseEntry(entry, pid)) {
+      if (reaped != NULL) {
+        reaped[count] = pid;
+      }
+      count++;
+    }
+  }
+  return count;
+}
+
+int countGenerators(myshm *myshm) {
+  int count = 0;
+  for (int i = 0; i < MAX_GENERATORS; i++) {
+    count += __atomic_load_n(&myshm->generators[i].pid, __ATOMIC_RELAXED) > 0;
+  }
+  return count;
 }
 
 void solveColorProblem(int* color_indices, edge removed_edges[], int *removed_edges_count, edge edges[], int numOfEdges) {
@@ -97,6 +431,54 @@ void solveColorProblem(int* color_indices, edge removed_edges[], int *removed_ed
   }
   *removed_edges_count = rem_count;
 }
+
+int countConflicts(int *color_indices, edge edges[], int numOfEdges, int limit) {
+  int count = 0;
+  for (int e = 0; e < numOfEdges && count < limit; e++) {
+    count += color_indices[edges[e].source] == color_indices[edges[e].destination];
+  }
+  return count;
+}
+
+int countConflictsPacked(const uint64_t *packed, edge edges[], int numOfEdges, int limit) {
+  int count = 0;
+  for (int e = 0; e < numOfEdges && count < limit; e++) {
+    count += getPackedColor(packed, edges[e].source) == getPackedColor(packed, edges[e].destination);
+  }
+  return count;
+}
+
+int solveColorProblemBounded(int *color_indices, edge edges[], int numOfEdges, int bound, edge removed_edges[], int *removed_edges_count) {
+  if (bound < 0) {
+    return 0;
+  }
+
+  int e = 0, first = -1, count = 0;
+  for (; e < numOfEdges; e++) {
+    if (color_indices[edges[e].source] == color_indices[edges[e].destination]) {
+      if (count == 0) {
+        first = e;
+      }
+      if (++count > bound) {
+        return 0;
+      }
+    }
+  }
+
+  // Winner, a second pass from the first conflicting edge until all of them are written
+  int rem_count = 0;
+  for (e = first; rem_count < count; e++) {
+    int source = edges[e].source;
+    int destination = edges[e].destination;
+    if (color_indices[source] == color_indices[destination]) {
+      removed_edges[rem_count].destination = source;
+      removed_edges[rem_count].source = destination;
+      rem_count += 1;
+    }
+  }
+  *removed_edges_count = rem_count;
+  return 1;
+}
   
 void printGraph(edge edges[], int numOfEdges) {
   for (int e = 0; e < numOfEdges; e++) {
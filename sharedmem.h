@@ -9,20 +9,42 @@
  * structured inside this module. The names for the shared memory object and the sizes for the circular buffer are also defined here.
  */
 
+#ifndef SHAREDMEM_H
+#define SHAREDMEM_H
+
 #include <semaphore.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <stdint.h>
 
 #define SHM_NAME "/51837398_myshm_gb"
+#define SHM_GRAPH_NAME "/51837398_graph_gb"
+#define SHM_ELITE_NAME "/51837398_elite_gb"
 #define USED_SEM "/51837398_used_sem"
-#define FREE_SEM "/51837398_free_sem"
-#define MUTEX_SEM "/51837398_mutex_sem"
 #define MAX_DATA (128)
 #define MAX_SOLUTION_EDGES (12)
+#define MAX_RING_SLOTS (1 << 24)
+#define MAX_RING_WIDTH (1 << 20)
+#define CACHE_LINE (64)
+#define WAIT_SPIN_ROUNDS (1 << 14)
+#define RING_ABANDONED (-1)
+#define MAX_JOB_NAME (32)
+#define MAX_OBJECT_NAME (64)
+#define MAX_JOBS (64)
+#define MAX_GENERATORS (64)
+#define HEARTBEAT_INTERVAL (100)
+#define ENTRY_RELEASING (-1)
+#define NO_ASSIGNMENT (-1)
+
+/** Encodes a search strategy and a seed (see search.h and seed.h) as one word for the registry */
+#define ASSIGNMENT(strategy, seed) (((strategy) << 8) | (seed))
+#define ASSIGNED_STRATEGY(assignment) ((assignment) >> 8)
+#define ASSIGNED_SEED(assignment) ((assignment) & 0xff)
 
 /** Represents the edge structure
  * @brief The source and destination represent the nodes
@@ -32,25 +54,137 @@ typedef struct edge {
   int destination;
 } edge;
 
-/** Represents the removed edge structure
+/** Represents the encodings of a solution in a cell
+ * @brief SOLUTION_EDGES stores the removed edges as pairs of input vertex ids. The other formats refer to the shared graph
+ * and are decoded by the supervisor (see solution.h): SOLUTION_COLORING stores the packed coloring (2 bits per vertex),
+ * SOLUTION_INDICES the ascending edge store indices of the removed edges as varint deltas.
+ */
+typedef enum solutionFormat {
+  SOLUTION_EDGES = 0,
+  SOLUTION_COLORING,
+  SOLUTION_INDICES
+} solutionFormat;
+
+/** Represents the removed edge structure, one cell of the circular buffer
  * @brief The removedEdge struct includes the number of edges and an array of edges that have been removed to make the graph 3-colorable
+ * The sequence number tells producers and the consumer who owns the cell (Vyukov bounded queue):
+ * sequence == pos means the cell is free for the producer claiming pos, sequence == pos + 1 means it holds
+ * the solution written for pos and may be read by the supervisor.
+ * A producer may reserve several consecutive cells at once and publish them with the sequence of the first cell only,
+ * batch is then the number of cells in the batch (set in the first cell, the others keep their free sequence).
+ * numOfEdges == RING_ABANDONED marks a reserved cell the producer did not fill, the supervisor skips it.
+ * format tells how the solution is stored in the payload (see solutionFormat), size is the number of payload bytes used.
+ * generator is the pid of the generator that wrote the solution (0 if it arrived over the network).
+ * The payload (edges) has room for myshm->max_edges edges, cells are myshm->slot_size bytes apart.
  */
 typedef struct removedEdge {
+    unsigned long sequence;
+    int batch;
     int numOfEdges;
-    edge edges[MAX_SOLUTION_EDGES];
+    int format;
+    int size;
+    int generator;
+    edge edges[];
 } removedEdge;
 
+/** Represents the counters of a generator
+ * @brief attempts is the number of search steps, submitted the number of solutions written to the buffer and rejected
+ * the number that were found but not written (too large for a cell, or beaten by another worker of the process).
+ * solve_ns is the time spent searching and blocked_ns the time spent waiting for free cells, in nanoseconds.
+ */
+typedef struct generatorCounters {
+	unsigned long attempts;
+	unsigned long submitted;
+	unsigned long rejected;
+	unsigned long solve_ns;
+	unsigned long blocked_ns;
+} generatorCounters;
+
+/** Represents a registered generator process
+ * @brief pid is 0 for a free entry and ENTRY_RELEASING while it is being freed. heartbeat is the getMonotonicMillis
+ * time the generator last reported, counters the totals of all its workers so far. The workers add their counts with
+ * relaxed atomics every HEARTBEAT_INTERVAL milliseconds, every entry has its own cache line. The supervisor derives
+ * rates from two readings.
+ * running is the strategy and seed the generator runs (see ASSIGNMENT), written by the generator. assigned is the
+ * one the supervisor wants it to run (NO_ASSIGNMENT to leave it alone), the workers poll it between search steps.
+ */
+typedef struct generatorEntry {
+	int pid;
+	int running;
+	int assigned;
+	unsigned long heartbeat;
+	generatorCounters counters;
+} __attribute__((aligned(CACHE_LINE))) generatorEntry;
+
+/** Represents the counters of the supervisor for one buffer
+ * @brief Written by the supervisor only, with relaxed atomics. drains is the number of times it read the buffer,
+ * cells the number of cells read (occupancy_sum / drains is the mean occupancy, occupancy_max the largest seen),
+ * abandoned the number of abandoned cells, stale the number of solutions that were no improvement and improvements
+ * the number of improvements. wakeups counts the waits for an empty buffer.
+ */
+typedef struct supervisorCounters {
+	unsigned long drains;
+	unsigned long cells;
+	unsigned long occupancy_max;
+	unsigned long abandoned;
+	unsigned long stale;
+	unsigned long improvements;
+	unsigned long wakeups;
+} __attribute__((aligned(CACHE_LINE))) supervisorCounters;
+
 /** Represents the mapping for the shared memory object
  * @brief The state will indicate if the program will terminate or not. (state == 1 means termination)
- * The generator count keeps track of the number of generator processes that are running
- * removedEdge represents the circular buffer with an array of edges in each cell
+ * optimal is the number of edges an exact search proved no solution can undercut (-1 if none did), the supervisor
+ * ends the job once it holds a solution with that many edges.
+ * best_solution is the number of edges of the best solution the supervisor has read so far (INT_MAX if none),
+ * generators only write solutions with fewer edges.
+ * head is the next position claimed by a producer, tail the next position read by the supervisor.
+ * Both live on their own cache line so producers and the consumer don't invalidate each other.
+ * sleeping is set by the supervisor before it parks in futex_wait on it, producers only wake it if it is set.
+ * generators is the registry of the running generator processes, see registerGenerator, supervisor the counters of the
+ * supervisor. Both can be read by any process that maps the object.
+ * The geometry (capacity, max_edges, slot_size and the total shm_size) is decided by the supervisor at startup
+ * and read by the generators from this header.
+ * slots represents the circular buffer with capacity cells of slot_size bytes each
  */
 typedef struct myshm {
     int state;
-	int generator_count;
-	removedEdge removed_edges[MAX_DATA];
+	int optimal;
+	int best_solution;
+	unsigned long capacity;
+	int max_edges;
+	size_t slot_size;
+	size_t shm_size;
+	unsigned long head __attribute__((aligned(CACHE_LINE)));
+	unsigned long tail __attribute__((aligned(CACHE_LINE)));
+	int sleeping __attribute__((aligned(CACHE_LINE)));
+	generatorEntry generators[MAX_GENERATORS];
+	supervisorCounters supervisor;
+	unsigned char slots[] __attribute__((aligned(CACHE_LINE)));
 } myshm;
 
+/** Represents the ways the supervisor waits for an empty circular buffer
+ * @brief WAIT_SPIN polls the buffer and never sleeps, WAIT_BLOCK sleeps right away and WAIT_ADAPTIVE polls
+ * WAIT_SPIN_ROUNDS times before it sleeps.
+ */
+typedef enum waitPolicy {
+  WAIT_SPIN = 0,
+  WAIT_ADAPTIVE,
+  WAIT_BLOCK,
+  NUM_WAIT_POLICIES
+} waitPolicy;
+
+/** Represents the names of the shared objects of a job
+ * @brief Without a job id the names are SHM_NAME, SHM_GRAPH_NAME, SHM_ELITE_NAME and USED_SEM, with one "_<job>" is appended to each,
+ * so any number of supervisors (or one supervisor with several jobs) can run side by side.
+ */
+typedef struct jobNames {
+  char shm[MAX_OBJECT_NAME];
+  char graph[MAX_OBJECT_NAME];
+  char elite[MAX_OBJECT_NAME];
+  char used_sem[MAX_OBJECT_NAME];
+} jobNames;
+
 /** Stores the program name
  * @brief The program name is specified by argv[0] at the start of main
  */
@@ -60,9 +194,9 @@ extern char *pgm_name;
  * Closes semaphores
  * @brief This function attempts to close any ressources of semaphore
  * @details If any attempt of closing fails, the function prints an error and exits
- * @param myshm The type of signal received.
+ * @param used_sem The semaphore the supervisor parks on.
 */
-void closeSemaphores(sem_t *used_sem, sem_t *free_sem, sem_t *mutex_sem);
+void closeSemaphores(sem_t *used_sem);
 
 /**
  * Unmaps the mapped shared memory object
@@ -72,45 +206,223 @@ void closeSemaphores(sem_t *used_sem, sem_t *free_sem, sem_t *mutex_sem);
 */
 void unmapSHM(myshm *myshm);
 
+/**
+ * Builds the object names of a job
+ * @param names The names to fill
+ * @param job The job id (1 to MAX_JOB_NAME letters, digits, '-' or '_'), or NULL for the default job
+ * @return Returns 0 on success, -1 if the job id is invalid.
+*/
+int initJobNames(jobNames *names, const char *job);
+
 /**
  * Unlinks any ressource 
  * @brief This function attempts to unlink any ressources of shared memory and semaphore
- * @details If any attempt of unlinking fails, the function prints an error and exits
+ * @details If any attempt of unlinking fails, the function prints an error and exits. A missing graph segment or elite pool is not an error.
+ * @param names The object names of the job
 */
-void unlinkRessources();
+void unlinkRessources(const jobNames *names);
 
 /**
  * Create the shared memory mapped object
  * @brief This function attempts to create the shared memory mapped object
- * @details If the attempt fails, or the file descriptor cannot be closed, the program prints an error and exits immediately
+ * @details The whole segment is mapped, its size is taken from the file descriptor.
+ * If the attempt fails, or the file descriptor cannot be closed, the program prints an error and exits immediately
  * @return Returns a mapped object of type myshm*.
 */
 myshm* createMappedSHMObject(int shmfd);
 
+/**
+ * Computes the size of the shared memory object
+ * @brief Header plus capacity cells holding up to max_edges edges each
+ * @param capacity The number of cells of the circular buffer
+ * @param max_edges The maximum number of removed edges per solution
+ * @return Returns the size in bytes.
+*/
+size_t getSHMSize(unsigned long capacity, int max_edges);
+
 /**
  * Create shared memory file descriptor
  * @brief This function attempts to create a file descriptor
  * @details If creation fails the function will print an error and exit immediately
+ * @param names The object names of the job
+ * @param size The size of the shared memory object, see getSHMSize
  * @return Returns a file descriptor (nonnegative integer).
 */
-int createSHMFileDescriptor();
+int createSHMFileDescriptor(const jobNames *names, size_t size);
 
 /**
  * Open a file descriptor of the shared memory object
  * @brief This function attempts to open a file descriptor of the shared memory object
  * @details If the attempt fails, the program prints an error and exits
+ * @param names The object names of the job
  * @return Returns a file descriptor (nonnegative integer).
 */
-int openSHMFileDescriptor();
+int openSHMFileDescriptor(const jobNames *names);
+
+/**
+ * Initializes the circular buffer
+ * @brief Writes the geometry into the header and resets head, tail and the sequence number of every cell
+ * @details Must be called by the supervisor before any generator can open USED_SEM
+ * @param myshm The mapped shared memory object
+ * @param capacity The number of cells of the circular buffer
+ * @param max_edges The maximum number of removed edges per solution
+*/
+void initializeRing(myshm *myshm, unsigned long capacity, int max_edges);
+
+/**
+ * Returns a cell of the circular buffer
+ * @brief Maps a position to its cell
+ * @param myshm The mapped shared memory object
+ * @param pos The position (head or tail value), taken modulo capacity
+ * @return Returns a pointer to the cell.
+*/
+static inline removedEdge* getSlot(myshm *myshm, unsigned long pos) {
+  return (removedEdge *) (myshm->slots + (pos % myshm->capacity) * myshm->slot_size);
+}
 
 /**
- * Randomizes the colors for the 3-colorable algorithm
- * @brief Each color_indices cell will be assigned a random color
- * @details Each cell in color_indices array represents a color (integer from 1 inclusive to 3 inclusive) which will be randomly created
- * @param numOfVertices The number of vertices
- * @param color_indices The color_indices int array
+ * Returns the payload size of a cell
+ * @param myshm The mapped shared memory object
+ * @return Returns the number of bytes a cell can hold after its header.
 */
-void randomizeColors(int numOfVertices, int *color_indices);
+static inline size_t getPayloadSize(const myshm *myshm) {
+  return (size_t) myshm->max_edges * sizeof(edge);
+}
+
+/**
+ * Reserves consecutive cells of the circular buffer
+ * @brief Claims count cells with a single compare-and-swap on head
+ * @details Lock-free and safe for any number of concurrent producers. Does not block if fewer than count cells are free.
+ * The consumer frees cells in order, so the batch is free once its last cell is.
+ * The cells are getSlot(myshm, *pos) to getSlot(myshm, *pos + count - 1) and must be published with ringPublish.
+ * @param myshm The mapped shared memory object
+ * @param count The number of cells (1 to myshm->capacity)
+ * @param pos The position of the first cell (pointer, set on success)
+ * @return Returns 0 on success, -1 if the buffer is too full.
+*/
+int ringReserve(myshm *myshm, int count, unsigned long *pos);
+
+/**
+ * Publishes reserved cells
+ * @brief Hands a filled batch to the supervisor with a single release store on the sequence of its first cell
+ * @param myshm The mapped shared memory object
+ * @param pos The position returned by ringReserve
+ * @param count The number of reserved cells
+*/
+void ringPublish(myshm *myshm, unsigned long pos, int count);
+
+/**
+ * Writes a solution into the circular buffer
+ * @brief Reserves, fills and publishes a single cell
+ * @details Does not block if the buffer is full. The cell has no generator (0).
+ * @param myshm The mapped shared memory object
+ * @param numOfEdges The number of removed edges
+ * @param removed_edges The removed edges (at most myshm->max_edges)
+ * @return Returns 0 on success, -1 if the buffer is full.
+*/
+int ringPush(myshm *myshm, int numOfEdges, edge removed_edges[]);
+
+/**
+ * Counts the readable cells of the circular buffer
+ * @brief Walks the published batches starting at tail, only the supervisor (single consumer) may call this
+ * @details The cells getSlot(myshm, tail) to getSlot(myshm, tail + count - 1) stay valid until ringRelease is called
+ * @param myshm The mapped shared memory object
+ * @return Returns the number of readable cells, 0 if the buffer is empty.
+*/
+unsigned long ringAvailable(myshm *myshm);
+
+/**
+ * Releases cells returned by ringAvailable
+ * @brief Hands the cells back to the producers and advances tail
+ * @param myshm The mapped shared memory object
+ * @param count The number of cells to release (at most the value returned by ringAvailable)
+*/
+void ringRelease(myshm *myshm, unsigned long count);
+
+/**
+ * Wakes the supervisor
+ * @brief Calls futex_wake on myshm->sleeping only if the supervisor announced that it is sleeping
+ * @details Called by producers after ringPublish, costs a fence and a single load if the supervisor is awake
+ * @param myshm The mapped shared memory object
+*/
+void ringWakeConsumer(myshm *myshm);
+
+/**
+ * Looks up a wait policy by name
+ * @param name The name ("spin", "adaptive" or "block")
+ * @return Returns the policy, or -1 if the name is unknown.
+*/
+int parseWaitPolicy(const char *name);
+
+/**
+ * Waits until one of the buffers is non-empty
+ * @brief Polls the buffers and/or sets their sleeping flags, re-checks the buffers and sleeps, see waitPolicy
+ * @details A single buffer sleeps in futex_wait, several in futex_waitv on all sleeping flags. Without futex_waitv the
+ * supervisor sleeps on the first buffer for at most a millisecond at a time. May return early (WAIT_SPIN returns after
+ * WAIT_SPIN_ROUNDS polls, any policy once timeout_ms passed), the caller has to check the buffers again
+ * @param rings The mapped shared memory objects
+ * @param count The number of buffers (1 to MAX_JOBS)
+ * @param policy How to wait
+ * @param timeout_ms The longest time to sleep in milliseconds, -1 for no limit
+ * @return Returns 0 on wakeup or timeout, -1 if the wait was interrupted by a signal.
+*/
+int ringWaitConsumer(myshm *rings[], int count, waitPolicy policy, long timeout_ms);
+
+/**
+ * Returns a monotonic clock
+ * @return Returns the CLOCK_MONOTONIC time in milliseconds.
+*/
+unsigned long getMonotonicMillis(void);
+
+/**
+ * Registers a generator
+ * @brief Claims a free entry of the registry with a compare-and-swap on its pid
+ * @details The entry has no assignment until the supervisor makes one
+ * @param myshm The mapped shared memory object
+ * @param pid The process id of the generator
+ * @param running The strategy and seed the generator starts with, see ASSIGNMENT
+ * @return Returns the entry, or NULL if all MAX_GENERATORS entries are taken (the generator runs unregistered).
+*/
+generatorEntry *registerGenerator(myshm *myshm, int pid, int running);
+
+/**
+ * Returns a monotonic clock
+ * @return Returns the CLOCK_MONOTONIC time in nanoseconds.
+*/
+unsigned long getMonotonicNanos(void);
+
+/**
+ * Reports the progress of a generator
+ * @brief Adds the counts of a worker to the entry, refreshes its heartbeat and clears the counts
+ * @param entry The entry returned by registerGenerator (may be NULL)
+ * @param delta The counts of the worker since its last report (cleared)
+*/
+void reportGenerator(generatorEntry *entry, generatorCounters *delta);
+
+/**
+ * Unregisters a generator
+ * @brief Frees the entry unless it was reaped and now belongs to another generator
+ * @param entry The entry returned by registerGenerator (may be NULL)
+ * @param pid The pid the entry was registered with
+*/
+void unregisterGenerator(generatorEntry *entry, int pid);
+
+/**
+ * Frees the entries of dead generators
+ * @brief Frees entries whose process is gone
+ * @details The heartbeat isn't used, it may be delayed for a long time by slow search steps or a full buffer
+ * @param myshm The mapped shared memory object
+ * @param reaped Stores the pids of the freed entries (room for MAX_GENERATORS, may be NULL)
+ * @return Returns the number of freed entries.
+*/
+int reapGenerators(myshm *myshm, int reaped[]);
+
+/**
+ * Counts the registered generators
+ * @param myshm The mapped shared memory object
+ * @return Returns the number of taken entries.
+*/
+int countGenerators(myshm *myshm);
 
 /**
  * Algorithm for the 3-color problem 
@@ -126,6 +438,46 @@ void randomizeColors(int numOfVertices, int *color_indices);
 */
 void solveColorProblem(int* color_indices, edge removed_edges[], int *removed_edges_count, edge edges[], int numOfEdges);
 
+/**
+ * Counts the conflicting edges of a coloring
+ * @brief Counts the edges whose vertices have the same color
+ * @details The scan stops as soon as limit conflicting edges have been found
+ * @param color_indices The color_indices array
+ * @param edges The edges array that is going to be checked
+ * @param numOfEdges The number of edges
+ * @param limit The count at which the scan stops
+ * @return Returns the number of conflicting edges, at most limit.
+*/
+int countConflicts(int *color_indices, edge edges[], int numOfEdges, int limit);
+
+/**
+ * Counts the conflicting edges of a packed coloring
+ * @brief Like countConflicts, but reads the colors from a packed coloring (2 bits per vertex, see random.h)
+ * @details The packed coloring is a sixteenth of the size of color_indices, so more of it stays in cache on large graphs
+ * @param packed The packed coloring
+ * @param edges The edges array that is going to be checked
+ * @param numOfEdges The number of edges
+ * @param limit The count at which the scan stops
+ * @return Returns the number of conflicting edges, at most limit.
+*/
+int countConflictsPacked(const uint64_t *packed, edge edges[], int numOfEdges, int limit);
+
+/**
+ * Bounded algorithm for the 3-color problem
+ * @brief Like solveColorProblem, but gives up as soon as more than bound edges would be removed
+ * @details A count-only scan runs first and stops once the count passes bound. Only if the coloring is within
+ * the bound, the conflicting edges are materialized into removed_edges, starting at the first conflicting edge.
+ * removed_edges therefore only needs room for bound edges.
+ * @param color_indices The color_indices array
+ * @param edges The edges array that is going to be checked
+ * @param numOfEdges The number of edges
+ * @param bound The maximum number of removed edges that is still accepted
+ * @param removed_edges The removed_edges array that will be filled (at least bound entries)
+ * @param removed_edges_count The count for removed_edges (pointer, only set if the coloring is accepted)
+ * @return Returns 1 if at most bound edges are removed, 0 otherwise.
+*/
+int solveColorProblemBounded(int *color_indices, edge edges[], int numOfEdges, int bound, edge removed_edges[], int *removed_edges_count);
+
 /**
  * Print edges
  * @brief This function prints the edges onto the console
@@ -142,3 +494,5 @@ void printGraph(edge edges[], int numOfEdges);
  * @param strerr This string is printed to stdout.
 */
 void printErrAndExit(char* strerr);
+
+#endif
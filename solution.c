@@ -0,0 +1,106 @@
+/**
+ * @file solution.c
+ * @author Giancarlo Buenaflor <e51837398@tuwien.ac.at>
+ * @date 18.11.2020
+ *
+ * @brief Implementation of the solution module.
+ *
+ **/
+
+#include "solution.h"
+#include "random.h"
+
+/**
+ * Compares two edge indices
+ * @return Returns a negative, zero or positive number like strcmp.
+*/
+static int compareIds(const void *a, const void *b) {
+  int x = *(const int *) a, y = *(const int *) b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * Writes a removed edge
+ * @brief Maps the vertices of edge e back to the input ids, oriented like solveColorProblem
+ * @param g The graph
+ * @param e The edge store index
+ * @param out The edge to fill
+*/
+static void writeEdge(const graph *g, int e, edge *out) {
+  int source = getEdgeSource(&g->store, e);
+  int destination = getEdgeDestination(&g->store, e);
+  if (g->old_id != NULL) {
+    source = g->old_id[source];
+    destination = g->old_id[destination];
+  }
+  out->destination = source;
+  out->source = destination;
+}
+
+size_t getColoringBytes(int numOfVertices) {
+  return (size_t) getPackedWords(numOfVertices) * sizeof(uint64_t);
+}
+
+void encodeColoring(removedEdge *slot, const int *color_indices, int numOfVertices) {
+  uint64_t *packed = (uint64_t *) slot->edges;
+  int words = getPackedWords(numOfVertices);
+  for (int w = 0; w < words; w++) {
+    uint64_t word = 0;
+    int end = (w + 1) * PACKED_COLORS_PER_WORD < numOfVertices ? (w + 1) * PACKED_COLORS_PER_WORD : numOfVertices;
+    for (int v = w * PACKED_COLORS_PER_WORD; v < end; v++) {
+      word |= (uint64_t) color_indices[v] << (2 * (v % PACKED_COLORS_PER_WORD));
+    }
+    packed[w] = word;
+  }
+  slot->format = SOLUTION_COLORING;
+  slot->size = words * sizeof(uint64_t);
+}
+
+int encodeIndices(removedEdge *slot, int edge_ids[], int count, size_t capacity) {
+  unsigned char *out = (unsigned char *) slot->edges;
+  size_t size = 0;
+  qsort(edge_ids, count, sizeof(int), compareIds);
+  for (int i = 0, prev = 0; i < count; i++) {
+    unsigned int delta = edge_ids[i] - prev;
+    prev = edge_ids[i];
+    do {
+      if (size == capacity) {
+        return 0;
+      }
+      out[size++] = (delta & 0x7f) | (delta >= 0x80 ? 0x80 : 0);
+      delta >>= 7;
+    } while (delta != 0);
+  }
+  slot->format = SOLUTION_INDICES;
+  slot->size = size;
+  return 1;
+}
+
+int decodeSolution(const removedEdge *slot, const graph *g, edge removed_edges[]) {
+  int count = 0;
+  if (slot->format == SOLUTION_COLORING) {
+    const uint64_t *packed = (const uint64_t *) slot->edges;
+    for (int e = 0; e < g->store.numOfEdges && count < slot->numOfEdges; e++) {
+      if (getPackedColor(packed, getEdgeSource(&g->store, e)) == getPackedColor(packed, getEdgeDestination(&g->store, e))) {
+        writeEdge(g, e, &removed_edges[count++]);
+      }
+    }
+  } else if (slot->format == SOLUTION_INDICES) {
+    const unsigned char *in = (const unsigned char *) slot->edges;
+    int pos = 0, e = 0;
+    while (pos < slot->size && count < slot->numOfEdges) {
+      unsigned int delta = 0;
+      int shift = 0;
+      do {
+        delta |= (unsigned int) (in[pos] & 0x7f) << shift;
+        shift += 7;
+      } while (in[pos++] & 0x80);
+      e += delta;
+      writeEdge(g, e, &removed_edges[count++]);
+    }
+  } else {
+    count = slot->numOfEdges;
+    memcpy(removed_edges, slot->edges, count * sizeof(edge));
+  }
+  return count;
+}
@@ -0,0 +1,59 @@
+/**
+ * @file solution.h
+ * @author Giancarlo Buenaflor <e51837398@tuwien.ac.at>
+ * @date 18.11.2020
+ *
+ * @brief Provides the compact encodings of solutions in the circular buffer.
+ *
+ * The solution module. Generators working on the shared graph don't need to send the removed edges as vertex pairs,
+ * the supervisor can reconstruct them from the graph: either from the packed coloring (a fixed 2 bits per vertex) or
+ * from the ascending edge indices, stored as LEB128 varint deltas (mostly 1 or 2 bytes per edge). The generator picks
+ * the smaller one, the supervisor only decodes the solutions it prints.
+ */
+
+#ifndef SOLUTION_H
+#define SOLUTION_H
+
+#include "sharedmem.h"
+#include "graph.h"
+
+/**
+ * Size of an encoded coloring
+ * @param numOfVertices The number of vertices
+ * @return Returns the number of payload bytes of a SOLUTION_COLORING cell.
+*/
+size_t getColoringBytes(int numOfVertices);
+
+/**
+ * Encodes a coloring
+ * @brief Writes the packed coloring into the payload of slot and sets its format and size
+ * @details The payload must have room for getColoringBytes(numOfVertices) bytes
+ * @param slot The cell
+ * @param color_indices The coloring (1 to 3 per vertex)
+ * @param numOfVertices The number of vertices
+*/
+void encodeColoring(removedEdge *slot, const int *color_indices, int numOfVertices);
+
+/**
+ * Encodes edge indices
+ * @brief Sorts edge_ids and writes them as varint deltas into the payload of slot, sets its format and size
+ * @param slot The cell
+ * @param edge_ids The edge store indices (distinct, sorted in place)
+ * @param count The number of indices
+ * @param capacity The maximum number of payload bytes to use
+ * @return Returns 1 on success, 0 if the encoding would need more than capacity bytes.
+*/
+int encodeIndices(removedEdge *slot, int edge_ids[], int count, size_t capacity);
+
+/**
+ * Decodes a solution
+ * @brief Reconstructs the removed edges of a cell with the graph it refers to
+ * @details The edges use the input vertex ids and are oriented like solveColorProblem writes them
+ * @param slot The cell (any format)
+ * @param g The shared graph (only used by the compact formats)
+ * @param removed_edges The removed_edges array that will be filled (slot->numOfEdges entries)
+ * @return Returns the number of edges written.
+*/
+int decodeSolution(const removedEdge *slot, const graph *g, edge removed_edges[]);
+
+#endif
@@ -19,7 +19,24 @@
 #include <unistd.h>
 #include <limits.h>
 #include <signal.h>
+#include <errno.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sched.h>
+#include <poll.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <time.h>
+#include <math.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
 #include "sharedmem.h"
+#include "graph.h"
+#include "solution.h"
+#include "net.h"
+#include "search.h"
+#include "seed.h"
 
 /** Stores an atomic variable quit
  * @brief If quit is set to 1, it signals to terminate all associated processes
@@ -49,70 +66,1881 @@ static void initializeSignalHandling() {
 	sigaction(SIGTERM, &sa, NULL);
 }
 
-/** Stores the semaphore indicating used spots in our circular buffer. 
- * @brief If used_sem is 0 then the generator won't be able to write onto the buffer
+/** Maximum length of the output prefix of a job */
+#define MAX_LABEL (256)
+
+/** Represents an improvement of the best solution of a job
+ * @brief time is the number of milliseconds since the job was opened, edges the size of the new best solution and
+ * generator the pid of the generator that found it (0 for remote generators).
+ */
+typedef struct improvement {
+	unsigned long time;
+	int edges;
+	int generator;
+} improvement;
+
+/** Represents the limits of the jobs (-timeout, -stall and -target)
+ * @brief timeout ends a job that many milliseconds after it was opened, stall once it didn't improve for that many
+ * milliseconds (0 for no limit). A job ends once its best solution has at most target edges.
+ */
+typedef struct jobLimits {
+	unsigned long timeout;
+	unsigned long stall;
+	int target;
+} jobLimits;
+
+/** Represents a job served by the supervisor
+ * @brief Every job has its own shared memory object, semaphore, shared graph and best solution.
+ * label prefixes the output of the job (the program name, followed by ":<id>" for named jobs)
+ * used_sem marks the circular buffer as ready, generators open it before they use the buffer. It is never posted, the
+ * supervisor sleeps on the futex myshm->sleeping.
+ * shared_graph is attached when the first compact solution arrives, done is set once the job is closed.
+ * started and improved are the getMonotonicMillis times the job was opened and last improved, trace holds all
+ * improvements in order (num_trace of trace_capacity used).
+ * gains[g] is the number of edges the generator in registry entry g improved the best solution by since the portfolio
+ * last looked (the first solution counts 1), see portfolio.
+ * held holds the latest improvement (an outputRecord and its edges, held_capacity bytes) if has_held is set: it
+ * didn't fit into the output queue yet. skipped counts the improvements it replaced since the last one was queued.
+ * status holds the status lines (status_size of status_capacity bytes, not terminated) that wait for the held
+ * improvement or for room in the queue, see emitStatus.
  */
-static sem_t *used_sem;
+typedef struct job {
+	const char *id;
+	const char *graph_path;
+	jobNames names;
+	char label[MAX_LABEL];
+	myshm *myshm;
+	sem_t *used_sem;
+	int curr_best_solution;
+	graph shared_graph;
+	int done;
+	unsigned long started;
+	unsigned long improved;
+	improvement *trace;
+	int num_trace;
+	int trace_capacity;
+	unsigned long gains[MAX_GENERATORS];
+	unsigned char *held;
+	size_t held_capacity;
+	int has_held;
+	int skipped;
+	char *status;
+	size_t status_size;
+	size_t status_capacity;
+} job;
+
+/** Maximum number of remote generators connected at once */
+#define MAX_CLIENTS (256)
 
-/** Stores the semaphore indicating free spots in our circular buffer. 
- * @brief If free_sem is 0 then the generator won't be able to read from the buffer
+/** Interval in milliseconds at which the listener broadcasts improved best solutions */
+#define BROADCAST_INTERVAL (20)
+
+/** Represents a remote generator
+ * @brief job is NULL until the generator sent NET_HELLO, sent_best is the best solution it was told last
  */
-static sem_t *free_sem;
+typedef struct client {
+	int fd;
+	job *job;
+	int sent_best;
+} client;
 
-/** Stores the semaphore used for synchronizing mutual access to a space
- * @brief If two processes try to manipulate a mutual variable, this semaphore will synchronize a correct behaviour
+/** Represents the listener thread serving the remote generators (-l)
+ * @brief The listener is a producer of the circular buffers like any local generator, so remote solutions take the same
+ * path through serveJob. stop is set by the main thread once the supervisor terminates.
+ * payload receives the edges of a solution, edges holds them in host byte order (max_edges each).
  */
-static sem_t *mutex_sem;
+typedef struct listener {
+	pthread_t thread;
+	int fd;
+	job *jobs;
+	int num_jobs;
+	int max_edges;
+	int stop;
+	client clients[MAX_CLIENTS];
+	int num_clients;
+	unsigned char *payload;
+	edge *edges;
+} listener;
+
+/** Guards the shared memory objects of the jobs against closeJob while the listener uses them */
+static pthread_mutex_t jobs_lock = PTHREAD_MUTEX_INITIALIZER;
 
 /**
  * Initialize semaphores function
- * @brief This function attempts to initialize semaphores used to synchronize between the generator and this supervisor
- * @details Three essential semaphores are initialized that are necessary for synchronizing the circular buffer read and write
+ * @brief This function attempts to create the semaphore that marks the circular buffer of a job as ready
+ * @details Must be called after the circular buffer is initialized, generators open the shared memory object
+ * before the semaphore and can therefore never see an uninitialized buffer
+ * @param j The job
 */
-static void initializeSemaphores() {
-	used_sem = sem_open(USED_SEM, O_CREAT | O_EXCL, 0600, 0);
-    if (used_sem == SEM_FAILED) {
+static void initializeSemaphores(job *j) {
+	j->used_sem = sem_open(j->names.used_sem, O_CREAT | O_EXCL, 0600, 0);
+    if (j->used_sem == SEM_FAILED) {
         printErrAndExit("USED_SEM failed creation");
     }
+}
 
-    free_sem = sem_open(FREE_SEM, O_CREAT | O_EXCL, 0600, MAX_DATA);
-    if (free_sem == SEM_FAILED) {
-        printErrAndExit("FREE_SEM failed creation");
-    }
+/**
+ * Opens a job
+ * @brief Publishes the graph of the job (if it has one), creates its shared memory object and semaphore
+ * @param j The job (id and graph_path set)
+ * @param capacity The number of cells of the circular buffer
+ * @param max_edges The maximum number of removed edges per solution
+*/
+static void openJob(job *j, unsigned long capacity, int max_edges) {
+	if (j->id == NULL) {
+		snprintf(j->label, sizeof(j->label), "%s", pgm_name);
+	} else {
+		snprintf(j->label, sizeof(j->label), "%s:%s", pgm_name, j->id);
+	}
 
-	mutex_sem = sem_open(MUTEX_SEM, O_CREAT | O_EXCL, 0600, 1);
-	if(mutex_sem == SEM_FAILED) {
-        printErrAndExit("MUTEX_SEM failed creation");
+	// A graph segment or elite pool left behind by a crashed supervisor would be picked up by new generators
+	if (shm_unlink(j->names.graph) == -1 && errno != ENOENT) {
+		printErrAndExit("Unlinking SHM graph object failed");
+	}
+	if (shm_unlink(j->names.elite) == -1 && errno != ENOENT) {
+		printErrAndExit("Unlinking SHM elite object failed");
 	}
+	if (j->graph_path != NULL) {
+		edgeList list = {0};
+		parseGraphFile(&list, j->graph_path);
+		uint64_t hash = hashEdgeList(&list);
+		graph g;
+		buildGraph(&g, &list, DEFAULT_REORDER_EDGES, 1);
+		freeEdgeList(&list);
+		publishGraph(&g, hash, j->names.graph);
+		freeGraph(&g);
+	}
+
+	int shmfd = createSHMFileDescriptor(&j->names, getSHMSize(capacity, max_edges));
+	j->myshm = createMappedSHMObject(shmfd);
+	initializeRing(j->myshm, capacity, max_edges);
+	initializeSemaphores(j);
+	j->curr_best_solution = INT_MAX;
+	j->started = getMonotonicMillis();
+	j->improved = j->started;
 }
 
-/** Stores the current read position in our buffer. 
- * @brief This variable is set inside the "readBuff(..)" function and represents the current read position
+/**
+ * Starts a background thread
+ * @details The thread blocks SIGINT and SIGTERM, so they always interrupt the main thread waiting for solutions.
+ * If the thread can't be created, the program prints an error and exits
+ * @param thread The thread (set)
+ * @param run The thread function
+ * @param arg The argument of run
+*/
+static void startBackgroundThread(pthread_t *thread, void *(*run)(void *), void *arg) {
+	sigset_t blocked, previous;
+	sigemptyset(&blocked);
+	sigaddset(&blocked, SIGINT);
+	sigaddset(&blocked, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+	if (pthread_create(thread, NULL, run, arg) != 0) {
+		printErrAndExit("Creating thread failed");
+	}
+	pthread_sigmask(SIG_SETMASK, &previous, NULL);
+}
+
+/** Minimum size in bytes of the output queue, see outputWriter */
+#define OUTPUT_QUEUE_BYTES (1 << 20)
+
+/** Interval in milliseconds at which the main thread retries to queue output that didn't fit */
+#define OUTPUT_RETRY (10)
+
+/** Represents the formats of the solution output (-format)
+ * @brief OUTPUT_TEXT prints the "[label] Solution with N edges: a - b ..." lines, OUTPUT_JSON one JSON object per
+ * solution and line, OUTPUT_BINARY one record per solution: the job index (in the order of the -j options), the number
+ * of edges, the generator pid, the number of skipped solutions and the milliseconds since the job was opened (high word
+ * first) followed by the source and destination of every edge, each as a 32 bit unsigned integer in network byte order.
  */
-static int rd_pos = 0;
+typedef enum outputFormat {
+	OUTPUT_TEXT = 0,
+	OUTPUT_JSON,
+	OUTPUT_BINARY,
+	NUM_OUTPUT_FORMATS
+} outputFormat;
+
+/** The names of the output formats, indexed by outputFormat */
+static const char *output_format_names[NUM_OUTPUT_FORMATS] = {"text", "json", "binary"};
+
+/** Represents a solution or status lines in the output queue
+ * @brief size is the number of bytes of the record including the edges that follow it. job is the index of the job,
+ * time the number of milliseconds since it was opened and generator the pid of the generator that found the solution
+ * (0 for remote generators). skipped is the number of earlier solutions of the job that were left out because the
+ * queue was full. A record with status > 0 is followed by that many bytes of status lines instead of edges, they are
+ * printed to stdout in every format.
+ */
+typedef struct outputRecord {
+	size_t size;
+	int job;
+	int edges;
+	int generator;
+	int skipped;
+	unsigned long time;
+	size_t status;
+} outputRecord;
+
+/** Represents the writer thread of the solutions
+ * @brief The main thread copies every improvement into queue, a byte ring of capacity bytes, and the writer formats and
+ * writes it to file, so a slow terminal or pipe never stalls the buffers. head and tail count the bytes ever queued and
+ * written, lock guards both and changed is signalled whenever one of them moves. The main thread never waits for the
+ * writer while it reads the buffers: if the queue is full it keeps the latest solution of the job and queues it once
+ * there is room, the ones in between are only counted (see job). The status lines of the jobs (limits, results) go
+ * through the queue as well, so they follow the solutions of their job. record is the copy of the record being written.
+ */
+typedef struct outputWriter {
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t changed;
+	FILE *file;
+	outputFormat format;
+	const job *jobs;
+	unsigned char *queue;
+	size_t capacity;
+	size_t head;
+	size_t tail;
+	int stop;
+	unsigned char *record;
+	size_t record_capacity;
+} outputWriter;
+
+/** Stores the writer of the solutions, started by main once the jobs are open */
+static outputWriter output = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.changed = PTHREAD_COND_INITIALIZER
+};
+
+/**
+ * Looks up an output format by name
+ * @param name The name ("text", "json" or "binary")
+ * @return Returns the format, or -1 if the name is unknown.
+*/
+static int parseOutputFormat(const char *name) {
+	for (int i = 0; i < NUM_OUTPUT_FORMATS; i++) {
+		if (strcmp(output_format_names[i], name) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+/**
+ * Copies bytes into the output queue
+ * @param w The writer
+ * @param pos The position in the queue (taken modulo capacity)
+ * @param src The bytes
+ * @param size The number of bytes
+*/
+static void copyToQueue(outputWriter *w, size_t pos, const void *src, size_t size) {
+	size_t offset = pos % w->capacity, first = size < w->capacity - offset ? size : w->capacity - offset;
+	memcpy(w->queue + offset, src, first);
+	memcpy(w->queue, (const unsigned char *) src + first, size - first);
+}
+
+/**
+ * Copies bytes out of the output queue
+ * @param w The writer
+ * @param pos The position in the queue (taken modulo capacity)
+ * @param dst The destination
+ * @param size The number of bytes
+*/
+static void copyFromQueue(const outputWriter *w, size_t pos, void *dst, size_t size) {
+	size_t offset = pos % w->capacity, first = size < w->capacity - offset ? size : w->capacity - offset;
+	memcpy(dst, w->queue + offset, first);
+	memcpy((unsigned char *) dst + first, w->queue, size - first);
+}
+
+/**
+ * Writes a 32 bit word in network byte order
+ * @param file The output
+ * @param value The word
+*/
+static void writeWord(FILE *file, uint32_t value) {
+	uint32_t word = htonl(value);
+	fwrite(&word, sizeof(word), 1, file);
+}
+
+/**
+ * Writes a solution
+ * @brief Formats the record in the format of the writer, status lines are copied to stdout
+ * @param w The writer
+ * @param record The record, followed by its edges or status lines
+*/
+static void writeRecord(outputWriter *w, const outputRecord *record) {
+	const job *j = &w->jobs[record->job];
+	const edge *edges = (const edge *) (record + 1);
+	FILE *file = w->file;
+	if (record->status > 0) {
+		fwrite(record + 1, 1, record->status, stdout);
+		fflush(stdout);
+		return;
+	}
+	// Other threads print to stdout too, the lines of a record stay together
+	flockfile(file);
+	switch (w->format) {
+		case OUTPUT_JSON:
+			fprintf(file, "{\"job\":\"%s\",\"seconds\":%.3f,\"edges\":%d,\"generator\":%d,\"skipped\":%d,\"removed\":[",
+				j->id != NULL ? j->id : "default", record->time / 1e3, record->edges, record->generator, record->skipped);
+			for (int k = 0; k < record->edges; k++) {
+				fprintf(file, k == 0 ? "[%d,%d]" : ",[%d,%d]", edges[k].source, edges[k].destination);
+			}
+			fprintf(file, "]}\n");
+			break;
+		case OUTPUT_BINARY:
+			writeWord(file, record->job);
+			writeWord(file, record->edges);
+			writeWord(file, record->generator);
+			writeWord(file, record->skipped);
+			writeWord(file, (uint64_t) record->time >> 32);
+			writeWord(file, (uint32_t) record->time);
+			for (int k = 0; k < record->edges; k++) {
+				writeWord(file, edges[k].source);
+				writeWord(file, edges[k].destination);
+			}
+			break;
+		default:
+			if (record->skipped > 0) {
+				fprintf(file, "[%s] Skipped %d solutions, the output couldn't keep up\n", j->label, record->skipped);
+			}
+			fprintf(file, "[%s] Solution with %d edges:", j->label, record->edges);
+			for (int k = 0; k < record->edges; k++) {
+				fprintf(file, " %d - %d ", edges[k].source, edges[k].destination);
+			}
+			fprintf(file, "\n");
+	}
+	funlockfile(file);
+}
+
+/**
+ * Writer thread function
+ * @brief Writes the queued records until output.stop is set and the queue is empty
+ * @details The lock is only held to read head and to move tail, never while writing. tail moves once the records are
+ * flushed, so an empty queue means everything queued so far is written.
+ * @param arg The writer (outputWriter*).
+ * @return Returns NULL.
+*/
+static void *runWriter(void *arg) {
+	outputWriter *w = arg;
+	pthread_mutex_lock(&w->lock);
+	for (;;) {
+		while (w->tail == w->head && !w->stop) {
+			pthread_cond_wait(&w->changed, &w->lock);
+		}
+		if (w->tail == w->head) {
+			break;
+		}
+		size_t head = w->head, tail = w->tail;
+		pthread_mutex_unlock(&w->lock);
+		while (tail != head) {
+			outputRecord header;
+			copyFromQueue(w, tail, &header, sizeof(header));
+			copyFromQueue(w, tail, w->record, header.size);
+			writeRecord(w, (const outputRecord *) w->record);
+			tail += header.size;
+		}
+		fflush(w->file);
+		pthread_mutex_lock(&w->lock);
+		w->tail = tail;
+		pthread_cond_broadcast(&w->changed);
+	}
+	pthread_mutex_unlock(&w->lock);
+	return NULL;
+}
+
+/**
+ * Waits until the output is written
+ * @brief Blocks until the writer thread has written and flushed every queued record
+ * @param w The writer
+*/
+static void drainOutput(outputWriter *w) {
+	pthread_mutex_lock(&w->lock);
+	while (w->tail != w->head) {
+		pthread_cond_wait(&w->changed, &w->lock);
+	}
+	pthread_mutex_unlock(&w->lock);
+}
+
+/**
+ * Queues a record
+ * @brief Copies the record and its edges or status lines into the queue and wakes the writer
+ * @details A record that doesn't fit into the queue at all (a job whose generators send compact ids may remove more
+ * than max_edges edges) grows the queue to hold two of them once it is empty. If allocating fails, the program prints an
+ * error and exits
+ * @param w The writer
+ * @param record The record (size is set here)
+ * @param payload The removed edges, or the status lines if record->status > 0
+ * @param wait 1 to wait for room in the queue, 0 to give up if it is full
+ * @return Returns 0 if the record was queued, -1 if the queue was full.
+*/
+static int queueOutput(outputWriter *w, outputRecord *record, const void *payload, int wait) {
+	record->size = sizeof(outputRecord) + (record->status > 0 ? record->status : (size_t) record->edges * sizeof(edge));
+	if (record->size > w->capacity) {
+		if (wait) {
+			drainOutput(w);
+		}
+		pthread_mutex_lock(&w->lock);
+		if (w->tail != w->head) {
+			pthread_mutex_unlock(&w->lock);
+			return -1;
+		}
+		// The writer is idle with an empty queue, neither buffer is in use
+		unsigned char *queue = realloc(w->queue, 2 * record->size);
+		unsigned char *buffer = queue != NULL ? realloc(w->record, 2 * record->size) : NULL;
+		if (buffer == NULL) {
+			printErrAndExit("Allocating output memory failed");
+		}
+		w->queue = queue;
+		w->record = buffer;
+		w->capacity = w->record_capacity = 2 * record->size;
+		w->head = w->tail = 0;
+		pthread_mutex_unlock(&w->lock);
+	}
+	pthread_mutex_lock(&w->lock);
+	while (w->capacity - (w->head - w->tail) < record->size) {
+		if (!wait) {
+			pthread_mutex_unlock(&w->lock);
+			return -1;
+		}
+		pthread_cond_wait(&w->changed, &w->lock);
+	}
+	size_t head = w->head;
+	pthread_mutex_unlock(&w->lock);
+	// Only the main thread moves head, the writer doesn't read past it
+	copyToQueue(w, head, record, sizeof(outputRecord));
+	copyToQueue(w, head + sizeof(outputRecord), payload, record->size - sizeof(outputRecord));
+	pthread_mutex_lock(&w->lock);
+	w->head = head + record->size;
+	pthread_cond_broadcast(&w->changed);
+	pthread_mutex_unlock(&w->lock);
+	return 0;
+}
+
+/**
+ * Queues the pending output of a job
+ * @brief Queues the latest solution that didn't fit into the queue (see emitSolution), then the status lines
+ * @param j The job
+ * @param wait 1 to wait for room in the queue, 0 to keep them pending if the queue is still full
+*/
+static void flushPending(job *j, int wait) {
+	if (j->has_held) {
+		outputRecord *record = (outputRecord *) j->held;
+		record->skipped = j->skipped;
+		if (queueOutput(&output, record, record + 1, wait) == -1) {
+			return;
+		}
+		j->has_held = 0;
+		j->skipped = 0;
+	}
+	if (j->status_size > 0) {
+		outputRecord record = {.job = j - output.jobs, .status = j->status_size};
+		if (queueOutput(&output, &record, j->status, wait) == 0) {
+			j->status_size = 0;
+		}
+	}
+}
+
+/**
+ * Checks for pending output
+ * @param j The job
+ * @return Returns 1 if a solution or status lines of the job wait to be queued, 0 otherwise.
+*/
+static int hasPendingOutput(const job *j) {
+	return j->has_held || j->status_size > 0;
+}
+
+/**
+ * Emits a status line
+ * @brief Appends the formatted line to the status lines of the job and queues them without waiting
+ * @details They are queued after the solutions of the job emitted before, so the order is kept although no thread
+ * waits for the writer. If allocating fails, the program prints an error and exits
+ * @param j The job
+ * @param format The printf format of the line (with its newline)
+*/
+static void emitStatus(job *j, const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(NULL, 0, format, args);
+	va_end(args);
+	if (j->status_capacity < j->status_size + length + 1) {
+		size_t capacity = 2 * (j->status_size + length + 1);
+		char *grown = realloc(j->status, capacity);
+		if (grown == NULL) {
+			printErrAndExit("Allocating output memory failed");
+		}
+		j->status = grown;
+		j->status_capacity = capacity;
+	}
+	va_start(args, format);
+	vsnprintf(j->status + j->status_size, length + 1, format, args);
+	va_end(args);
+	j->status_size += length;
+	flushPending(j, 0);
+}
+
+/**
+ * Emits a solution
+ * @brief Queues an improvement of a job for the writer thread without waiting
+ * @details If the queue is full, the solution is copied and held until there is room, replacing (and counting) a
+ * solution held before. If allocating fails, the program prints an error and exits
+ * @param j The job
+ * @param edges The removed edges
+ * @param count The number of removed edges
+ * @param generator The pid of the generator that found the solution
+*/
+static void emitSolution(job *j, const edge edges[], int count, int generator) {
+	outputRecord record = {
+		.job = j - output.jobs,
+		.edges = count,
+		.generator = generator,
+		.skipped = j->skipped + j->has_held,
+		.time = getMonotonicMillis() - j->started
+	};
+	// Status lines never come before a solution of their job
+	if (j->status_size == 0 && queueOutput(&output, &record, edges, 0) == 0) {
+		j->has_held = 0;
+		j->skipped = 0;
+		return;
+	}
+	j->skipped += j->has_held;
+	if (j->held_capacity < record.size) {
+		unsigned char *grown = realloc(j->held, record.size);
+		if (grown == NULL) {
+			printErrAndExit("Allocating output memory failed");
+		}
+		j->held = grown;
+		j->held_capacity = record.size;
+	}
+	memcpy(j->held, &record, sizeof(outputRecord));
+	memcpy(j->held + sizeof(outputRecord), edges, record.size - sizeof(outputRecord));
+	j->has_held = 1;
+}
+
+/**
+ * Starts the writer thread
+ * @brief Allocates the queue, which holds at least two records of max_edges edges
+ * @details If allocating fails or the thread can't be created, the program prints an error and exits
+ * @param w The writer (file and format set)
+ * @param jobs The jobs
+ * @param max_edges The maximum number of removed edges per solution
+*/
+static void startWriter(outputWriter *w, const job jobs[], int max_edges) {
+	size_t largest = sizeof(outputRecord) + (size_t) max_edges * sizeof(edge);
+	w->jobs = jobs;
+	w->capacity = 2 * largest > OUTPUT_QUEUE_BYTES ? 2 * largest : OUTPUT_QUEUE_BYTES;
+	w->record_capacity = w->capacity;
+	w->queue = malloc(w->capacity);
+	w->record = malloc(w->record_capacity);
+	if (w->queue == NULL || w->record == NULL) {
+		printErrAndExit("Allocating output memory failed");
+	}
+	startBackgroundThread(&w->thread, runWriter, w);
+}
+
+/**
+ * Stops the writer thread
+ * @brief Lets the writer write what is queued, joins it and closes the output file
+ * @param w The writer
+*/
+static void stopWriter(outputWriter *w) {
+	pthread_mutex_lock(&w->lock);
+	w->stop = 1;
+	pthread_cond_broadcast(&w->changed);
+	pthread_mutex_unlock(&w->lock);
+	pthread_join(w->thread, NULL);
+	if (w->file != stdout && fclose(w->file) != 0) {
+		fprintf(stderr, "[%s] Couldn't write the output file\n", pgm_name);
+	}
+	free(w->queue);
+	free(w->record);
+}
+
+/**
+ * Closes a job
+ * @brief Tells the generators of the job to terminate, emits its result and removes its ressources
+ * @details The result is queued after the solutions of the job, see emitStatus
+ * @param j The job
+*/
+static void closeJob(job *j) {
+	pthread_mutex_lock(&jobs_lock);
+	if (j->shared_graph.mapping != NULL) {
+		freeGraph(&j->shared_graph);
+	}
+
+	// Generators never block on the buffer, they poll state between attempts
+	__atomic_store_n(&j->myshm->state, 1, __ATOMIC_RELEASE);
+
+	if (j->curr_best_solution == INT_MAX) {
+		emitStatus(j, "[%s] No solution found\n", j->label);
+	} else {
+		emitStatus(j, "[%s] Best found solution: %d edges\n", j->label, j->curr_best_solution);
+	}
+	if (j->curr_best_solution == 0) {
+		emitStatus(j, "[%s] The graph is 3-colorable!\n", j->label);
+	}
+
+	/* CLOSE, UNLINK AND DEALLOCATE  */
+	closeSemaphores(j->used_sem);
+	unmapSHM(j->myshm);
+	unlinkRessources(&j->names);
+	j->done = 1;
+	pthread_mutex_unlock(&jobs_lock);
+}
+
+/**
+ * Finds the job a remote generator asks for
+ * @param l The listener
+ * @param id The job id (length bytes, not terminated), empty for the default job
+ * @param length The length of id
+ * @return Returns the job, or NULL if the supervisor doesn't serve it.
+*/
+static job *findJob(listener *l, const char *id, uint32_t length) {
+	for (int i = 0; i < l->num_jobs; i++) {
+		const char *name = l->jobs[i].id;
+		if (name == NULL ? length == 0 : strlen(name) == length && memcmp(name, id, length) == 0) {
+			return &l->jobs[i];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Accepts a remote generator
+ * @details Connections beyond MAX_CLIENTS are refused
+ * @param l The listener
+*/
+static void acceptClient(listener *l) {
+	int fd = accept(l->fd, NULL, NULL);
+	if (fd == -1) {
+		return;
+	}
+	if (l->num_clients == MAX_CLIENTS) {
+		close(fd);
+		return;
+	}
+	l->clients[l->num_clients++] = (client) {.fd = fd, .job = NULL, .sent_best = INT_MAX};
+}
+
+/**
+ * Submits a remote solution
+ * @brief Writes the solution into the circular buffer of its job and wakes the main thread
+ * @details Solutions that don't undercut the best solution of the job are dropped. If the buffer is full the listener
+ * retries, releasing jobs_lock in between so the main thread can drain (or close) the job.
+ * @param l The listener
+ * @param j The job
+ * @param count The number of removed edges (in l->edges)
+*/
+static void submitRemote(listener *l, job *j, int count) {
+	while (!__atomic_load_n(&l->stop, __ATOMIC_ACQUIRE)) {
+		pthread_mutex_lock(&jobs_lock);
+		if (j->done || count >= __atomic_load_n(&j->myshm->best_solution, __ATOMIC_RELAXED)) {
+			pthread_mutex_unlock(&jobs_lock);
+			return;
+		}
+		if (ringPush(j->myshm, count, l->edges) == 0) {
+			ringWakeConsumer(j->myshm);
+			pthread_mutex_unlock(&jobs_lock);
+			return;
+		}
+		pthread_mutex_unlock(&jobs_lock);
+		sched_yield();
+	}
+}
+
+/**
+ * Serves a message of a remote generator
+ * @brief Answers NET_HELLO with NET_WELCOME and submits NET_SOLUTION messages
+ * @param l The listener
+ * @param c The remote generator
+ * @return Returns 0 on success, -1 if the connection should be closed (failed, invalid message or unknown job).
+*/
+static int serveClient(listener *l, client *c) {
+	netHeader header;
+	if (netReceive(c->fd, &header, l->payload, 8 * (uint32_t) l->max_edges) == -1) {
+		return -1;
+	}
+	if (header.type == NET_HELLO && c->job == NULL) {
+		job *j = findJob(l, (const char *) l->payload, header.length);
+		if (j == NULL) {
+			return -1;
+		}
+		pthread_mutex_lock(&jobs_lock);
+		int done = j->done;
+		uint32_t best = done ? 0 : __atomic_load_n(&j->myshm->best_solution, __ATOMIC_RELAXED);
+		uint32_t geometry[2] = {htonl(done ? 0 : j->myshm->capacity), htonl(l->max_edges)};
+		pthread_mutex_unlock(&jobs_lock);
+		if (done || netSend(c->fd, NET_WELCOME, best, 0, geometry, sizeof(geometry)) == -1) {
+			return -1;
+		}
+		c->job = j;
+		c->sent_best = best;
+		return 0;
+	}
+	if (header.type == NET_SOLUTION && c->job != NULL) {
+		// Remote generators have no shared graph, only edge pairs can be decoded
+		if (header.format != SOLUTION_EDGES || header.value > (uint32_t) l->max_edges || header.length != 8 * header.value) {
+			return -1;
+		}
+		netDecodeEdges(l->edges, l->payload, header.value);
+		submitRemote(l, c->job, header.value);
+		return 0;
+	}
+	return -1;
+}
+
+/**
+ * Broadcasts the best solutions
+ * @brief Sends NET_BEST to every remote generator whose job improved since it was told last
+ * @details Remote generators of a closed job are told its final result and disconnected.
+ * @param l The listener
+*/
+static void broadcastBest(listener *l) {
+	for (int i = l->num_clients - 1; i >= 0; i--) {
+		client *c = &l->clients[i];
+		if (c->job == NULL) {
+			continue;
+		}
+		pthread_mutex_lock(&jobs_lock);
+		int done = c->job->done;
+		int best = done ? c->job->curr_best_solution : __atomic_load_n(&c->job->myshm->best_solution, __ATOMIC_RELAXED);
+		pthread_mutex_unlock(&jobs_lock);
+		int failed = 0;
+		if (best < c->sent_best) {
+			failed = netSend(c->fd, NET_BEST, best, 0, NULL, 0) == -1;
+			c->sent_best = best;
+		}
+		if (done || failed) {
+			close(c->fd);
+			l->clients[i] = l->clients[--l->num_clients];
+		}
+	}
+}
+
+/**
+ * Listener thread function
+ * @brief Accepts remote generators, serves their messages and broadcasts the best solutions until l->stop is set
+ * @param arg The listener (listener*).
+ * @return Returns NULL.
+*/
+static void *runListener(void *arg) {
+	listener *l = arg;
+	struct pollfd fds[MAX_CLIENTS + 1];
+	while (!__atomic_load_n(&l->stop, __ATOMIC_ACQUIRE)) {
+		fds[0] = (struct pollfd) {.fd = l->fd, .events = POLLIN};
+		for (int i = 0; i < l->num_clients; i++) {
+			fds[i + 1] = (struct pollfd) {.fd = l->clients[i].fd, .events = POLLIN};
+		}
+		if (poll(fds, l->num_clients + 1, BROADCAST_INTERVAL) > 0) {
+			// Backwards, a dropped client is replaced by the last one, which is already served
+			for (int i = l->num_clients - 1; i >= 0; i--) {
+				if (fds[i + 1].revents != 0 && serveClient(l, &l->clients[i]) == -1) {
+					close(l->clients[i].fd);
+					l->clients[i] = l->clients[--l->num_clients];
+				}
+			}
+			if (fds[0].revents & POLLIN) {
+				acceptClient(l);
+			}
+		}
+		broadcastBest(l);
+	}
+	for (int i = 0; i < l->num_clients; i++) {
+		close(l->clients[i].fd);
+	}
+	return NULL;
+}
+
+/**
+ * Starts the listener thread
+ * @param l The listener
+ * @param port The TCP port
+ * @param jobs The jobs
+ * @param num_jobs The number of jobs
+ * @param max_edges The maximum number of removed edges per solution
+*/
+static void startListener(listener *l, int port, job jobs[], int num_jobs, int max_edges) {
+	l->fd = netListen(port);
+	l->jobs = jobs;
+	l->num_jobs = num_jobs;
+	l->max_edges = max_edges;
+	l->payload = malloc(8 * (size_t) max_edges + 1);
+	l->edges = malloc((size_t) max_edges * sizeof(edge) + 1);
+	if (l->payload == NULL || l->edges == NULL) {
+		printErrAndExit("Allocating listener memory failed");
+	}
+
+	startBackgroundThread(&l->thread, runListener, l);
+}
+
+/**
+ * Stops the listener thread
+ * @brief Disconnects all remote generators and closes the listening socket
+ * @param l The listener
+*/
+static void stopListener(listener *l) {
+	__atomic_store_n(&l->stop, 1, __ATOMIC_RELEASE);
+	pthread_join(l->thread, NULL);
+	close(l->fd);
+	free(l->payload);
+	free(l->edges);
+}
+
+/** Interval in milliseconds between two decisions of the scaler */
+#define SCALE_INTERVAL (1000)
+
+/** Tolerance in percent around the target cpu utilization before the scaler acts */
+#define SCALE_SLACK (5)
+
+/** Maximum number of arguments of the spawned generator command */
+#define MAX_SPAWN_ARGS (32)
+
+/** Default target cpu utilization in percent and generator command of the scaler */
+#define DEFAULT_TARGET_CPU (90)
+#define DEFAULT_SPAWN_COMMAND "./generator"
+
+/** Represents the scaler thread (-scale)
+ * @brief Reaps the registry entries of dead generators and forks or stops local generators so the host stays at
+ * target_cpu percent utilization, or, if target_rate is set, every job prints about target_rate improvements per second.
+ * command is the generator command line split into words, the scaler appends "-j <id>" for named jobs. Spawned
+ * generators get no graph and attach to the shared graph of their job, so only jobs with one are scaled.
+ * spawned holds the pids of the running spawned generators and spawned_job the index of their job, youngest last.
+ * prev_pid and prev_attempts remember the registry of every job at the last decision, prev_improvements its improvements.
+ */
+typedef struct scaler {
+	pthread_t thread;
+	job *jobs;
+	int num_jobs;
+	int max_spawned;
+	int target_cpu;
+	int target_rate;
+	int stop;
+	char *command[MAX_SPAWN_ARGS + 3];
+	char job_flag[3];
+	int spawned[MAX_GENERATORS];
+	int spawned_job[MAX_GENERATORS];
+	int num_spawned;
+	int prev_pid[MAX_JOBS][MAX_GENERATORS];
+	unsigned long prev_attempts[MAX_JOBS][MAX_GENERATORS];
+	unsigned long prev_improvements[MAX_JOBS];
+	unsigned long long prev_busy, prev_total;
+} scaler;
+
+/**
+ * Reads the cpu times of the host
+ * @param busy The time spent outside idle and iowait (pointer, set)
+ * @param total The total time (pointer, set)
+ * @return Returns 0 on success, -1 if /proc/stat can't be read.
+*/
+static int readCpuTimes(unsigned long long *busy, unsigned long long *total) {
+	unsigned long long t[8] = {0};
+	FILE *stat = fopen("/proc/stat", "r");
+	if (stat == NULL) {
+		return -1;
+	}
+	int n = fscanf(stat, "cpu %llu %llu %llu %llu %llu %llu %llu %llu", &t[0], &t[1], &t[2], &t[3], &t[4], &t[5], &t[6], &t[7]);
+	fclose(stat);
+	if (n < 4) {
+		return -1;
+	}
+	*total = 0;
+	for (int i = 0; i < 8; i++) {
+		*total += t[i];
+	}
+	*busy = *total - t[3] - t[4];
+	return 0;
+}
+
+/**
+ * Measures the attempts per second of a job
+ * @brief Sums the growth of the attempts of every registry entry since the last decision
+ * @details Must be called with jobs_lock held on a job that is not done
+ * @param sc The scaler
+ * @param index The index of the job
+ * @param seconds The time since the last decision
+ * @return Returns the attempts per second.
+*/
+static unsigned long measureAttempts(scaler *sc, int index, double seconds) {
+	myshm *myshm = sc->jobs[index].myshm;
+	unsigned long sum = 0;
+	for (int i = 0; i < MAX_GENERATORS; i++) {
+		int pid = __atomic_load_n(&myshm->generators[i].pid, __ATOMIC_ACQUIRE);
+		unsigned long attempts = __atomic_load_n(&myshm->generators[i].counters.attempts, __ATOMIC_RELAXED);
+		if (pid > 0 && pid == sc->prev_pid[index][i] && attempts >= sc->prev_attempts[index][i]) {
+			sum += attempts - sc->prev_attempts[index][i];
+		}
+		sc->prev_pid[index][i] = pid;
+		sc->prev_attempts[index][i] = attempts;
+	}
+	return seconds > 0 ? sum / seconds : 0;
+}
+
+/**
+ * Spawns a generator for a job
+ * @details The child unblocks the signals blocked by the scaler thread and discards its output
+ * @param sc The scaler
+ * @param index The index of the job
+ * @return Returns the pid, or -1 if fork failed.
+*/
+static int spawnGenerator(scaler *sc, int index) {
+	int pid = fork();
+	if (pid != 0) {
+		if (pid > 0) {
+			sc->spawned[sc->num_spawned] = pid;
+			sc->spawned_job[sc->num_spawned++] = index;
+		}
+		return pid;
+	}
+	sigset_t none;
+	sigemptyset(&none);
+	sigprocmask(SIG_SETMASK, &none, NULL);
+	int null = open("/dev/null", O_WRONLY);
+	if (null != -1) {
+		dup2(null, STDOUT_FILENO);
+		close(null);
+	}
+	char **argv = sc->command;
+	int argc = 0;
+	while (argv[argc] != NULL) {
+		argc++;
+	}
+	if (sc->jobs[index].id != NULL) {
+		argv[argc] = sc->job_flag;
+		argv[argc + 1] = (char *) sc->jobs[index].id;
+		argv[argc + 2] = NULL;
+	}
+	execvp(argv[0], argv);
+	fprintf(stderr, "[%s] Couldn't start %s\n", pgm_name, argv[0]);
+	_exit(EXIT_FAILURE);
+}
+
+/**
+ * Stops the youngest spawned generator
+ * @brief Sends it SIGTERM, it finishes its pending solutions and unregisters itself
+ * @param sc The scaler
+ * @param index The index of the job, or -1 for any job
+ * @return Returns the pid, or -1 if no generator was spawned for the job.
+*/
+static int stopGenerator(scaler *sc, int index) {
+	for (int i = sc->num_spawned - 1; i >= 0; i--) {
+		if (index == -1 || sc->spawned_job[i] == index) {
+			int pid = sc->spawned[i];
+			kill(pid, SIGTERM);
+			return pid;
+		}
+	}
+	return -1;
+}
+
+/**
+ * Collects the spawned generators that exited
+ * @brief Waits for them, so their pids are gone before the registry is reaped
+ * @param sc The scaler
+*/
+static void collectGenerators(scaler *sc) {
+	for (int i = sc->num_spawned - 1; i >= 0; i--) {
+		if (waitpid(sc->spawned[i], NULL, WNOHANG) != 0) {
+			sc->num_spawned--;
+			memmove(&sc->spawned[i], &sc->spawned[i + 1], (sc->num_spawned - i) * sizeof(int));
+			memmove(&sc->spawned_job[i], &sc->spawned_job[i + 1], (sc->num_spawned - i) * sizeof(int));
+		}
+	}
+}
+
+/**
+ * Checks if a job can be scaled
+ * @param j The job
+ * @return Returns 1 if spawned generators find a shared graph for the job.
+*/
+static int hasSharedGraph(const job *j) {
+	int fd = shm_open(j->names.graph, O_RDONLY, 0);
+	if (fd == -1) {
+		return 0;
+	}
+	close(fd);
+	return 1;
+}
+
+/**
+ * Makes one scaling decision
+ * @brief Reaps the registries, then spawns or stops at most one generator per job (per host for the cpu target)
+ * @param sc The scaler
+ * @param seconds The time since the last decision
+*/
+static void scaleGenerators(scaler *sc, double seconds) {
+	collectGenerators(sc);
+
+	unsigned long long busy = 0, total = 0;
+	int cpu = -1;
+	if (readCpuTimes(&busy, &total) == 0 && total > sc->prev_total) {
+		cpu = 100 * (busy - sc->prev_busy) / (total - sc->prev_total);
+	}
+	sc->prev_busy = busy;
+	sc->prev_total = total;
+
+	// The job with the fewest generators gets the next one when scaling by cpu
+	int fewest = -1, fewest_count = INT_MAX;
+	for (int i = 0; i < sc->num_jobs; i++) {
+		job *j = &sc->jobs[i];
+		int reaped[MAX_GENERATORS];
+		pthread_mutex_lock(&jobs_lock);
+		if (j->done) {
+			pthread_mutex_unlock(&jobs_lock);
+			continue;
+		}
+		int num_reaped = reapGenerators(j->myshm, reaped);
+		int count = countGenerators(j->myshm);
+		unsigned long attempts = measureAttempts(sc, i, seconds);
+		unsigned long improvements = __atomic_load_n(&j->myshm->supervisor.improvements, __ATOMIC_RELAXED);
+		pthread_mutex_unlock(&jobs_lock);
+		for (int k = 0; k < num_reaped; k++) {
+			printf("[%s] Reaped generator %d\n", j->label, reaped[k]);
+		}
+		if (!hasSharedGraph(j)) {
+			continue;
+		}
+		if (count < fewest_count) {
+			fewest = i, fewest_count = count;
+		}
+
+		if (sc->target_rate > 0) {
+			double rate = seconds > 0 ? (improvements - sc->prev_improvements[i]) / seconds : 0;
+			sc->prev_improvements[i] = improvements;
+			int pid = -1;
+			if (rate < sc->target_rate && sc->num_spawned < sc->max_spawned) {
+				pid = spawnGenerator(sc, i);
+				printf("[%s] Spawned generator %d (%.1f improvements/s, %lu attempts/s)\n", j->label, pid, rate, attempts);
+			} else if (rate > 2 * sc->target_rate && (pid = stopGenerator(sc, i)) != -1) {
+				printf("[%s] Stopped generator %d (%.1f improvements/s, %lu attempts/s)\n", j->label, pid, rate, attempts);
+			}
+		}
+	}
+
+	if (sc->target_rate == 0 && cpu != -1) {
+		// A generator keeps about one core busy, it is only started or stopped if that doesn't overshoot the target
+		long cores = sysconf(_SC_NPROCESSORS_ONLN);
+		int share = 100 / (cores > 0 ? cores : 1), pid;
+		if (cpu + share <= sc->target_cpu + SCALE_SLACK && sc->num_spawned < sc->max_spawned && fewest != -1) {
+			pid = spawnGenerator(sc, fewest);
+			printf("[%s] Spawned generator %d (cpu %d%%)\n", sc->jobs[fewest].label, pid, cpu);
+		} else if (cpu > sc->target_cpu + SCALE_SLACK && cpu - share >= sc->target_cpu - SCALE_SLACK
+			&& (pid = stopGenerator(sc, -1)) != -1) {
+			printf("[%s] Stopped generator %d (cpu %d%%)\n", pgm_name, pid, cpu);
+		}
+	}
+	fflush(stdout);
+}
+
+/**
+ * Scaler thread function
+ * @brief Makes a scaling decision every SCALE_INTERVAL milliseconds until sc->stop is set
+ * @param arg The scaler (scaler*).
+ * @return Returns NULL.
+*/
+static void *runScaler(void *arg) {
+	scaler *sc = arg;
+	unsigned long last = getMonotonicMillis();
+	readCpuTimes(&sc->prev_busy, &sc->prev_total);
+	while (!__atomic_load_n(&sc->stop, __ATOMIC_ACQUIRE)) {
+		struct timespec tick = {0, 100 * 1000000};
+		nanosleep(&tick, NULL);
+		unsigned long now = getMonotonicMillis();
+		if (now - last >= SCALE_INTERVAL) {
+			scaleGenerators(sc, (now - last) / 1000.0);
+			last = now;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Starts the scaler thread
+ * @param sc The scaler (max_spawned, target_cpu and target_rate set)
+ * @param command The generator command line, words separated by spaces (modified)
+ * @param jobs The jobs
+ * @param num_jobs The number of jobs
+ * @return Returns 0 on success, -1 if the command is empty or has more than MAX_SPAWN_ARGS words.
+*/
+static int startScaler(scaler *sc, char *command, job jobs[], int num_jobs) {
+	int argc = 0;
+	for (char *word = strtok(command, " "); word != NULL; word = strtok(NULL, " ")) {
+		if (argc == MAX_SPAWN_ARGS) {
+			return -1;
+		}
+		sc->command[argc++] = word;
+	}
+	if (argc == 0) {
+		return -1;
+	}
+	sc->command[argc] = NULL;
+	strcpy(sc->job_flag, "-j");
+	sc->jobs = jobs;
+	sc->num_jobs = num_jobs;
+	startBackgroundThread(&sc->thread, runScaler, sc);
+	return 0;
+}
+
+/**
+ * Stops the scaler thread
+ * @brief Joins the thread, the spawned generators keep running until their job is closed
+ * @param sc The scaler
+*/
+static void stopScaler(scaler *sc) {
+	__atomic_store_n(&sc->stop, 1, __ATOMIC_RELEASE);
+	pthread_join(sc->thread, NULL);
+}
+
+/**
+ * Waits for the spawned generators
+ * @details Called after all jobs are closed, so the generators are terminating
+ * @param sc The scaler
+*/
+static void waitSpawned(scaler *sc) {
+	for (int i = 0; i < sc->num_spawned; i++) {
+		waitpid(sc->spawned[i], NULL, 0);
+	}
+	sc->num_spawned = 0;
+}
+
+/** Represents a reading of the counters of a job
+ * @brief taken is 0 for a closed job, pids and generators are copied from the registry (pid 0 for free entries)
+ */
+typedef struct jobSnapshot {
+	int taken;
+	int best_solution;
+	unsigned long capacity;
+	supervisorCounters supervisor;
+	int pids[MAX_GENERATORS];
+	generatorCounters generators[MAX_GENERATORS];
+} jobSnapshot;
+
+/** Represents the stats thread (-stats)
+ * @brief Every interval seconds it reads the counters of all jobs, prints their rates since the last reading and
+ * rewrites the Prometheus text file prom_path (if set). last holds the previous reading of every job.
+ */
+typedef struct statsReporter {
+	pthread_t thread;
+	job *jobs;
+	int num_jobs;
+	int interval;
+	const char *prom_path;
+	int stop;
+	jobSnapshot current[MAX_JOBS];
+	jobSnapshot last[MAX_JOBS];
+} statsReporter;
+
+/** Represents a counter exported to Prometheus
+ * @brief offset is the position of the counter in generatorCounters or supervisorCounters, nanosecond counters are
+ * exported in seconds
+ */
+typedef struct metric {
+	const char *name;
+	const char *type;
+	const char *help;
+	size_t offset;
+	int nanoseconds;
+} metric;
+
+static const metric generator_metrics[] = {
+	{"threecolor_generator_attempts_total", "counter", "Search steps", offsetof(generatorCounters, attempts), 0},
+	{"threecolor_generator_submitted_total", "counter", "Solutions written to the buffer", offsetof(generatorCounters, submitted), 0},
+	{"threecolor_generator_rejected_total", "counter", "Solutions found but not written", offsetof(generatorCounters, rejected), 0},
+	{"threecolor_generator_solve_seconds_total", "counter", "Time spent searching", offsetof(generatorCounters, solve_ns), 1},
+	{"threecolor_generator_blocked_seconds_total", "counter", "Time spent waiting for free cells", offsetof(generatorCounters, blocked_ns), 1}
+};
+
+static const metric supervisor_metrics[] = {
+	{"threecolor_ring_drains_total", "counter", "Reads of the buffer", offsetof(supervisorCounters, drains), 0},
+	{"threecolor_ring_cells_total", "counter", "Cells read", offsetof(supervisorCounters, cells), 0},
+	{"threecolor_ring_occupancy_max", "gauge", "Most cells read at once", offsetof(supervisorCounters, occupancy_max), 0},
+	{"threecolor_ring_abandoned_total", "counter", "Abandoned cells", offsetof(supervisorCounters, abandoned), 0},
+	{"threecolor_ring_stale_total", "counter", "Solutions that were no improvement", offsetof(supervisorCounters, stale), 0},
+	{"threecolor_ring_improvements_total", "counter", "Improved solutions", offsetof(supervisorCounters, improvements), 0},
+	{"threecolor_ring_wakeups_total", "counter", "Waits for an empty buffer", offsetof(supervisorCounters, wakeups), 0}
+};
+
+/**
+ * Reads a counter
+ * @param counters The counters (generatorCounters or supervisorCounters)
+ * @param offset The position of the counter
+ * @return Returns the counter.
+*/
+static unsigned long readCounter(const void *counters, size_t offset) {
+	return __atomic_load_n((const unsigned long *) ((const char *) counters + offset), __ATOMIC_RELAXED);
+}
+
+/**
+ * Reads the counters of all jobs
+ * @param st The stats thread
+*/
+static void takeSnapshots(statsReporter *st) {
+	for (int i = 0; i < st->num_jobs; i++) {
+		jobSnapshot *snap = &st->current[i];
+		pthread_mutex_lock(&jobs_lock);
+		snap->taken = !st->jobs[i].done;
+		if (snap->taken) {
+			myshm *myshm = st->jobs[i].myshm;
+			snap->best_solution = __atomic_load_n(&myshm->best_solution, __ATOMIC_RELAXED);
+			snap->capacity = myshm->capacity;
+			for (size_t m = 0; m < sizeof(supervisor_metrics) / sizeof(metric); m++) {
+				size_t offset = supervisor_metrics[m].offset;
+				*(unsigned long *) ((char *) &snap->supervisor + offset) = readCounter(&myshm->supervisor, offset);
+			}
+			for (int g = 0; g < MAX_GENERATORS; g++) {
+				int pid = __atomic_load_n(&myshm->generators[g].pid, __ATOMIC_ACQUIRE);
+				// An entry that is being freed counts as free
+				snap->pids[g] = pid > 0 ? pid : 0;
+				for (size_t m = 0; m < sizeof(generator_metrics) / sizeof(metric); m++) {
+					size_t offset = generator_metrics[m].offset;
+					*(unsigned long *) ((char *) &snap->generators[g] + offset) = readCounter(&myshm->generators[g].counters, offset);
+				}
+			}
+		}
+		pthread_mutex_unlock(&jobs_lock);
+	}
+}
+
+/**
+ * Growth of a counter
+ * @details A counter that shrank belongs to a new generator in a reused entry, its whole value is the growth
+ * @return Returns the growth of a counter from before to now.
+*/
+static unsigned long counterDelta(unsigned long now, unsigned long before) {
+	return now >= before ? now - before : now;
+}
+
+/**
+ * Prints the rates of all jobs
+ * @brief One line per job and one per generator, rates are per second since the last reading
+ * @param st The stats thread
+ * @param seconds The time since the last reading
+*/
+static void printStats(statsReporter *st, double seconds) {
+	for (int i = 0; i < st->num_jobs; i++) {
+		const jobSnapshot *now = &st->current[i], *before = &st->last[i];
+		if (!now->taken) {
+			continue;
+		}
+		const char *label = st->jobs[i].label;
+		const supervisorCounters *sn = &now->supervisor, *sb = &before->supervisor;
+		unsigned long drains = counterDelta(sn->drains, sb->drains), cells = counterDelta(sn->cells, sb->cells);
+		unsigned long attempts = 0, submitted = 0, rejected = 0;
+		int count = 0;
+		for (int g = 0; g < MAX_GENERATORS; g++) {
+			if (now->pids[g] == 0) {
+				continue;
+			}
+			const generatorCounters *gn = &now->generators[g];
+			generatorCounters zero = {0};
+			const generatorCounters *gb = now->pids[g] == before->pids[g] ? &before->generators[g] : &zero;
+			unsigned long a = counterDelta(gn->attempts, gb->attempts), s = counterDelta(gn->submitted, gb->submitted);
+			unsigned long r = counterDelta(gn->rejected, gb->rejected);
+			unsigned long solve = counterDelta(gn->solve_ns, gb->solve_ns), blocked = counterDelta(gn->blocked_ns, gb->blocked_ns);
+			printf("[%s] Generator %d: %.0f attempts/s, %.1f submitted/s, %.1f rejected/s, %.1f%% blocked\n", label,
+				now->pids[g], a / seconds, s / seconds, r / seconds, solve + blocked > 0 ? 100.0 * blocked / (solve + blocked) : 0.0);
+			attempts += a, submitted += s, rejected += r;
+			count++;
+		}
+		printf("[%s] Stats: %d generators, %.0f attempts/s, %.1f submitted/s, %.1f rejected/s, "
+			"%.1f cells/s, occupancy %.1f (max %lu of %lu), %.1f abandoned/s, %.1f stale/s, %.1f waits/s\n", label,
+			count, attempts / seconds, submitted / seconds, rejected / seconds, cells / seconds,
+			drains > 0 ? (double) cells / drains : 0.0, sn->occupancy_max, now->capacity,
+			counterDelta(sn->abandoned, sb->abandoned) / seconds, counterDelta(sn->stale, sb->stale) / seconds,
+			counterDelta(sn->wakeups, sb->wakeups) / seconds);
+	}
+	fflush(stdout);
+}
+
+/**
+ * Writes the Prometheus text file
+ * @brief Writes all counters of the open jobs, labeled with the job (and pid), to a temporary file renamed to prom_path
+ * @details Errors are reported but not fatal, the next interval tries again
+ * @param st The stats thread
+*/
+static void writePrometheus(statsReporter *st) {
+	char tmp_path[PATH_MAX];
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", st->prom_path);
+	FILE *out = fopen(tmp_path, "w");
+	if (out == NULL) {
+		fprintf(stderr, "[%s] Couldn't write %s\n", pgm_name, tmp_path);
+		return;
+	}
+	for (size_t m = 0; m < sizeof(generator_metrics) / sizeof(metric); m++) {
+		const metric *mt = &generator_metrics[m];
+		fprintf(out, "# HELP %s %s\n# TYPE %s %s\n", mt->name, mt->help, mt->name, mt->type);
+		for (int i = 0; i < st->num_jobs; i++) {
+			const jobSnapshot *snap = &st->current[i];
+			for (int g = 0; snap->taken && g < MAX_GENERATORS; g++) {
+				if (snap->pids[g] != 0) {
+					unsigned long value = readCounter(&snap->generators[g], mt->offset);
+					fprintf(out, "%s{job=\"%s\",pid=\"%d\"} ", mt->name, st->jobs[i].id != NULL ? st->jobs[i].id : "default", snap->pids[g]);
+					fprintf(out, mt->nanoseconds ? "%.9f\n" : "%.0f\n", mt->nanoseconds ? value / 1e9 : (double) value);
+				}
+			}
+		}
+	}
+	for (size_t m = 0; m < sizeof(supervisor_metrics) / sizeof(metric); m++) {
+		const metric *mt = &supervisor_metrics[m];
+		fprintf(out, "# HELP %s %s\n# TYPE %s %s\n", mt->name, mt->help, mt->name, mt->type);
+		for (int i = 0; i < st->num_jobs; i++) {
+			if (st->current[i].taken) {
+				fprintf(out, "%s{job=\"%s\"} %lu\n", mt->name, st->jobs[i].id != NULL ? st->jobs[i].id : "default",
+					readCounter(&st->current[i].supervisor, mt->offset));
+			}
+		}
+	}
+	fprintf(out, "# HELP threecolor_best_solution Edges of the best solution\n# TYPE threecolor_best_solution gauge\n");
+	for (int i = 0; i < st->num_jobs; i++) {
+		if (st->current[i].taken && st->current[i].best_solution != INT_MAX) {
+			fprintf(out, "threecolor_best_solution{job=\"%s\"} %d\n", st->jobs[i].id != NULL ? st->jobs[i].id : "default",
+				st->current[i].best_solution);
+		}
+	}
+	if (fclose(out) != 0 || rename(tmp_path, st->prom_path) == -1) {
+		fprintf(stderr, "[%s] Couldn't write %s\n", pgm_name, st->prom_path);
+	}
+}
+
+/**
+ * Stats thread function
+ * @brief Reads, prints and exports the counters every st->interval seconds until st->stop is set
+ * @param arg The stats thread (statsReporter*).
+ * @return Returns NULL.
+*/
+static void *runStats(void *arg) {
+	statsReporter *st = arg;
+	takeSnapshots(st);
+	memcpy(st->last, st->current, sizeof(st->last));
+	unsigned long last = getMonotonicMillis();
+	while (!__atomic_load_n(&st->stop, __ATOMIC_ACQUIRE)) {
+		struct timespec tick = {0, 100 * 1000000};
+		nanosleep(&tick, NULL);
+		unsigned long now = getMonotonicMillis();
+		if (now - last >= (unsigned long) st->interval * 1000) {
+			takeSnapshots(st);
+			printStats(st, (now - last) / 1000.0);
+			if (st->prom_path != NULL) {
+				writePrometheus(st);
+			}
+			memcpy(st->last, st->current, sizeof(st->last));
+			last = now;
+		}
+	}
+	return NULL;
+}
+
+/** Factor by which the portfolio discounts the history of every arm at each decision, so it follows the search */
+#define PORTFOLIO_DECAY (0.8)
+
+/** Weight of the exploration bonus of an arm against its normalized improvement rate */
+#define PORTFOLIO_EXPLORATION (0.5)
+
+/** Search time in seconds an arm needs before its improvement rate is trusted */
+#define PORTFOLIO_MIN_SECONDS (1.0)
+
+/** At most 1 / PORTFOLIO_SWITCH_FRACTION of the generators of a job (at least one) are reassigned per decision */
+#define PORTFOLIO_SWITCH_FRACTION (4)
+
+/** Represents a strategy of the portfolio
+ * @brief A generator assigned to the arm runs strategy starting from seed, see search.h and seed.h
+ */
+typedef struct portfolioArm {
+	const char *name;
+	int strategy;
+	int seed;
+} portfolioArm;
+
+/** Number of arms of the portfolio */
+#define NUM_ARMS (5)
+
+/** The arms of the portfolio, the exact strategy is left out because it only pays off once it is exhausted */
+static const portfolioArm arms[NUM_ARMS] = {
+	{"random", STRATEGY_RANDOM, SEED_DSATUR},
+	{"minconf", STRATEGY_MINCONF, SEED_DSATUR},
+	{"minconf-rgreedy", STRATEGY_MINCONF, SEED_RGREEDY},
+	{"tabu", STRATEGY_TABU, SEED_DSATUR},
+	{"tabu-rgreedy", STRATEGY_TABU, SEED_RGREEDY}
+};
+
+/** Represents the history of an arm on one job
+ * @brief gain is the number of edges the best solution improved by through generators of the arm, seconds their
+ * search time, both discounted by PORTFOLIO_DECAY at every decision
+ */
+typedef struct armStats {
+	double gain;
+	double seconds;
+} armStats;
+
+/** Represents the portfolio thread (-portfolio)
+ * @brief Every interval seconds it credits the improvements (job.gains) and the search time of every registered
+ * generator to the arm it runs, and moves generators between arms with a discounted UCB policy: the generators of a job
+ * are dealt out one at a time to the arm with the best normalized improvement per search second plus exploration bonus,
+ * each pick lowers the bonus of that arm. Only generators running one of the arms are scheduled, see generatorEntry.
+ * prev_pid and prev_solve_ns remember the registry of every job at the last decision, shown the last printed allocation.
+ */
+typedef struct portfolio {
+	pthread_t thread;
+	job *jobs;
+	int num_jobs;
+	int interval;
+	int stop;
+	armStats arms[MAX_JOBS][NUM_ARMS];
+	int prev_pid[MAX_JOBS][MAX_GENERATORS];
+	unsigned long prev_solve_ns[MAX_JOBS][MAX_GENERATORS];
+	int shown[MAX_JOBS][NUM_ARMS];
+} portfolio;
+
+/**
+ * Looks up the arm of an assignment
+ * @param assignment The strategy and seed, see ASSIGNMENT
+ * @return Returns the index of the arm, or -1 if no arm runs them.
+*/
+static int findArm(int assignment) {
+	for (int a = 0; a < NUM_ARMS; a++) {
+		if (assignment == ASSIGNMENT(arms[a].strategy, arms[a].seed)) {
+			return a;
+		}
+	}
+	return -1;
+}
+
+/**
+ * Scores an arm
+ * @param stats The arm
+ * @param seconds The search time of the arm including the picks so far
+ * @param best_rate The best improvement rate of all trusted arms (0 if there is none)
+ * @param total The search time of all arms
+ * @return Returns the normalized rate plus the exploration bonus, arms without PORTFOLIO_MIN_SECONDS come first (the
+ * least explored one first).
+*/
+static double scoreArm(const armStats *stats, double seconds, double best_rate, double total) {
+	if (seconds < PORTFOLIO_MIN_SECONDS) {
+		return 1e9 - seconds;
+	}
+	double rate = best_rate > 0 ? stats->gain / stats->seconds / best_rate : 0;
+	return rate + PORTFOLIO_EXPLORATION * sqrt(log(total + 1) / seconds);
+}
+
+/**
+ * Prints the allocation of a job if it changed
+ * @param pf The portfolio
+ * @param i The index of the job
+ * @param have The number of generators of every arm
+*/
+static void printAllocation(portfolio *pf, int i, const int have[]) {
+	if (memcmp(have, pf->shown[i], sizeof(pf->shown[i])) == 0) {
+		return;
+	}
+	memcpy(pf->shown[i], have, sizeof(pf->shown[i]));
+	printf("[%s] Portfolio:", pf->jobs[i].label);
+	for (int a = 0; a < NUM_ARMS; a++) {
+		const armStats *stats = &pf->arms[i][a];
+		if (have[a] > 0) {
+			printf(" %s %d (%.2f/s)", arms[a].name, have[a], stats->seconds > 0 ? stats->gain / stats->seconds : 0);
+		}
+	}
+	printf("\n");
+	fflush(stdout);
+}
+
+/**
+ * Schedules the generators of a job
+ * @brief Credits the progress since the last decision to the arms, computes how many generators every arm should get
+ * and reassigns at most 1 / PORTFOLIO_SWITCH_FRACTION of the generators that are on an arm with too many
+ * @details A generator that wasn't told yet counts for the arm it was assigned to
+ * @param pf The portfolio
+ * @param i The index of the job
+*/
+static void scheduleJob(portfolio *pf, int i) {
+	job *j = &pf->jobs[i];
+	armStats *stats = pf->arms[i];
+	int slots[MAX_GENERATORS], slot_arm[MAX_GENERATORS], num_slots = 0;
+	int have[NUM_ARMS] = {0}, want[NUM_ARMS] = {0};
+
+	pthread_mutex_lock(&jobs_lock);
+	if (j->done) {
+		pthread_mutex_unlock(&jobs_lock);
+		return;
+	}
+	for (int a = 0; a < NUM_ARMS; a++) {
+		stats[a].gain *= PORTFOLIO_DECAY;
+		stats[a].seconds *= PORTFOLIO_DECAY;
+	}
+	for (int g = 0; g < MAX_GENERATORS; g++) {
+		generatorEntry *entry = &j->myshm->generators[g];
+		int pid = __atomic_load_n(&entry->pid, __ATOMIC_ACQUIRE);
+		unsigned long gain = __atomic_exchange_n(&j->gains[g], 0, __ATOMIC_RELAXED);
+		if (pid <= 0 || __atomic_load_n(&entry->heartbeat, __ATOMIC_ACQUIRE) == 0) {
+			pf->prev_pid[i][g] = 0;
+			continue;
+		}
+		unsigned long solve_ns = __atomic_load_n(&entry->counters.solve_ns, __ATOMIC_RELAXED);
+		if (pid != pf->prev_pid[i][g]) {
+			pf->prev_pid[i][g] = pid;
+			pf->prev_solve_ns[i][g] = 0;
+		}
+		int arm = findArm(__atomic_load_n(&entry->running, __ATOMIC_RELAXED));
+		if (arm != -1) {
+			stats[arm].gain += gain;
+			stats[arm].seconds += (solve_ns - pf->prev_solve_ns[i][g]) / 1e9;
+		}
+		pf->prev_solve_ns[i][g] = solve_ns;
+		int assigned = __atomic_load_n(&entry->assigned, __ATOMIC_RELAXED);
+		if (assigned != NO_ASSIGNMENT) {
+			arm = findArm(assigned);
+		}
+		if (arm != -1) {
+			slots[num_slots] = g;
+			slot_arm[num_slots++] = arm;
+			have[arm]++;
+		}
+	}
+
+	double best_rate = 0, total = 0, seconds[NUM_ARMS];
+	for (int a = 0; a < NUM_ARMS; a++) {
+		seconds[a] = stats[a].seconds;
+		total += stats[a].seconds;
+		if (stats[a].seconds >= PORTFOLIO_MIN_SECONDS && stats[a].gain / stats[a].seconds > best_rate) {
+			best_rate = stats[a].gain / stats[a].seconds;
+		}
+	}
+	for (int k = 0; k < num_slots; k++) {
+		int best = 0;
+		double best_score = -1;
+		for (int a = 0; a < NUM_ARMS; a++) {
+			double score = scoreArm(&stats[a], seconds[a], best_rate, total);
+			if (score > best_score) {
+				best = a, best_score = score;
+			}
+		}
+		want[best]++;
+		// A generator searches about interval seconds until the next decision
+		seconds[best] += pf->interval;
+	}
+
+	int switches = num_slots / PORTFOLIO_SWITCH_FRACTION > 0 ? num_slots / PORTFOLIO_SWITCH_FRACTION : 1;
+	for (int k = 0; k < num_slots && switches > 0; k++) {
+		int from = slot_arm[k];
+		if (have[from] <= want[from]) {
+			continue;
+		}
+		for (int to = 0; to < NUM_ARMS; to++) {
+			if (have[to] < want[to]) {
+				generatorEntry *entry = &j->myshm->generators[slots[k]];
+				__atomic_store_n(&entry->assigned, ASSIGNMENT(arms[to].strategy, arms[to].seed), __ATOMIC_RELAXED);
+				have[from]--;
+				have[to]++;
+				switches--;
+				break;
+			}
+		}
+	}
+	pthread_mutex_unlock(&jobs_lock);
+	if (num_slots > 0) {
+		printAllocation(pf, i, have);
+	}
+}
+
+/**
+ * Portfolio thread function
+ * @brief Schedules the generators of every job every pf->interval seconds until pf->stop is set
+ * @param arg The portfolio (portfolio*).
+ * @return Returns NULL.
+*/
+static void *runPortfolio(void *arg) {
+	portfolio *pf = arg;
+	unsigned long last = getMonotonicMillis();
+	while (!__atomic_load_n(&pf->stop, __ATOMIC_ACQUIRE)) {
+		struct timespec tick = {0, 100 * 1000000};
+		nanosleep(&tick, NULL);
+		unsigned long now = getMonotonicMillis();
+		if (now - last >= (unsigned long) pf->interval * 1000) {
+			for (int i = 0; i < pf->num_jobs; i++) {
+				scheduleJob(pf, i);
+			}
+			last = now;
+		}
+	}
+	return NULL;
+}
 
 /**
  * Read buffer function
- * @brief This function reads the circular buffer in our shared memory object.
- * @details Only reads if free_sem is > 0
- * @param edges_to_read A removedEdge array that represents the circular buffer.
- * @return Returns an integer referring to the amount of edges that have been removed.
+ * @brief This function waits until one of the circular buffers in our shared memory objects is non-empty.
+ * @details Waits with the given policy while all buffers are empty, but not past the deadline.
+ * global variables: quit
+ * @param rings The mapped shared memory objects.
+ * @param count The number of buffers.
+ * @param policy How to wait, see waitPolicy
+ * @param deadline The getMonotonicMillis time to stop waiting at, 0 for none
+ * @return Returns 0 if a buffer is non-empty, 1 if the deadline passed, -1 if the wait was interrupted by a signal.
+*/
+static int readBuff(myshm *rings[], int count, waitPolicy policy, unsigned long deadline) {
+	for (;;) {
+		for (int i = 0; i < count; i++) {
+			if (ringAvailable(rings[i]) != 0) {
+				return 0;
+			}
+		}
+		long timeout = -1;
+		if (deadline != 0) {
+			unsigned long now = getMonotonicMillis();
+			if (now >= deadline) {
+				return 1;
+			}
+			timeout = deadline - now;
+		}
+		// Only the supervisor writes its counters, a plain increment is enough
+		for (int i = 0; i < count; i++) {
+			__atomic_store_n(&rings[i]->supervisor.wakeups, rings[i]->supervisor.wakeups + 1, __ATOMIC_RELAXED);
+		}
+		if (quit || ringWaitConsumer(rings, count, policy, timeout) == -1) {
+			return -1;
+		}
+	}
+}
+
+/**
+ * Decodes the removed edges of a solution
+ * @brief Returns the edges of SOLUTION_EDGES cells directly, the compact formats are decoded into decoded
+ * @details The shared graph is attached when the first compact solution arrives, generators only send those
+ * once it exists. decoded grows as needed, if allocating fails the program prints an error and exits
+ * @param solution The cell
+ * @param j The job of the cell (its shared graph is attached on demand)
+ * @param decoded The decoding buffer (pointer)
+ * @param decoded_capacity The number of edges decoded can hold (pointer)
+ * @return Returns the removed edges of the solution.
+*/
+static const edge* decodeEdges(const removedEdge *solution, job *j, edge **decoded, int *decoded_capacity) {
+	if (solution->format == SOLUTION_EDGES) {
+		return solution->edges;
+	}
+	if (j->shared_graph.mapping == NULL) {
+		loadGraph(&j->shared_graph, NULL, 0, j->names.graph);
+	}
+	if (solution->numOfEdges > *decoded_capacity) {
+		edge *grown = realloc(*decoded, solution->numOfEdges * sizeof(edge));
+		if (grown == NULL) {
+			printErrAndExit("Allocating decoding memory failed");
+		}
+		*decoded = grown;
+		*decoded_capacity = solution->numOfEdges;
+	}
+	decodeSolution(solution, &j->shared_graph, *decoded);
+	return *decoded;
+}
+
+/**
+ * Records an improvement
+ * @brief Sets the best solution of the job, appends it to the trace and credits the gain to the generator
+ * @details The trace grows as needed, if allocating fails the program prints an error and exits
+ * @param j The job
+ * @param edges The number of edges of the new best solution
+ * @param generator The pid of the generator that found it
+*/
+static void recordImprovement(job *j, int edges, int generator) {
+	if (j->num_trace == j->trace_capacity) {
+		int capacity = j->trace_capacity == 0 ? 64 : 2 * j->trace_capacity;
+		improvement *grown = realloc(j->trace, capacity * sizeof(improvement));
+		if (grown == NULL) {
+			printErrAndExit("Allocating trace memory failed");
+		}
+		j->trace = grown;
+		j->trace_capacity = capacity;
+	}
+	j->improved = getMonotonicMillis();
+	j->trace[j->num_trace++] = (improvement) {
+		.time = j->improved - j->started,
+		.edges = edges,
+		.generator = generator
+	};
+	for (int g = 0; generator != 0 && g < MAX_GENERATORS; g++) {
+		if (__atomic_load_n(&j->myshm->generators[g].pid, __ATOMIC_RELAXED) == generator) {
+			__atomic_add_fetch(&j->gains[g], j->curr_best_solution == INT_MAX ? 1 : j->curr_best_solution - edges, __ATOMIC_RELAXED);
+			break;
+		}
+	}
+	j->curr_best_solution = edges;
+}
+
+/**
+ * Serves a job
+ * @brief Reads all cells published so far, emits the improvements and publishes the best solution to the generators
+ * @details A solution with 0 edges closes the job, so does a solution with myshm->optimal edges (proven optimal by an
+ * exact generator). The counters of the buffer are updated once per call. The improvements are handed to the writer
+ * thread, see emitSolution, so reading never waits for the output.
+ * @param j The job
+ * @param decoded The decoding buffer, see decodeEdges
+ * @param decoded_capacity The number of edges decoded can hold (pointer)
+*/
+static void serveJob(job *j, edge **decoded, int *decoded_capacity) {
+	myshm *myshm = j->myshm;
+	unsigned long available = ringAvailable(myshm);
+	unsigned long tail = __atomic_load_n(&myshm->tail, __ATOMIC_RELAXED);
+	unsigned long abandoned = 0, stale = 0, improvements = 0;
+	flushPending(j, 0);
+	for (unsigned long i = 0; i < available; i++) {
+		removedEdge *solution = getSlot(myshm, tail + i);
+		int temp = solution->numOfEdges;
+		if (temp == RING_ABANDONED) {
+			abandoned++;
+			continue;
+		}
+		if (temp == 0) {
+			recordImprovement(j, 0, solution->generator);
+			improvements++;
+			break;
+		}
+		if (temp < j->curr_best_solution) {
+			emitSolution(j, decodeEdges(solution, j, decoded, decoded_capacity), temp, solution->generator);
+			recordImprovement(j, temp, solution->generator);
+			improvements++;
+		} else {
+			stale++;
+		}
+	}
+	if (available > 0) {
+		supervisorCounters *counters = &myshm->supervisor;
+		__atomic_store_n(&counters->drains, counters->drains + 1, __ATOMIC_RELAXED);
+		__atomic_store_n(&counters->cells, counters->cells + available, __ATOMIC_RELAXED);
+		__atomic_store_n(&counters->abandoned, counters->abandoned + abandoned, __ATOMIC_RELAXED);
+		__atomic_store_n(&counters->stale, counters->stale + stale, __ATOMIC_RELAXED);
+		__atomic_store_n(&counters->improvements, counters->improvements + improvements, __ATOMIC_RELAXED);
+		if (available > counters->occupancy_max) {
+			__atomic_store_n(&counters->occupancy_max, available, __ATOMIC_RELAXED);
+		}
+		__atomic_store_n(&myshm->best_solution, j->curr_best_solution, __ATOMIC_RELAXED);
+		ringRelease(myshm, available);
+	}
+	// Set by the generator after it wrote its solutions, which may not have been read yet
+	int optimal = __atomic_load_n(&myshm->optimal, __ATOMIC_ACQUIRE);
+	if (j->curr_best_solution > 0 && j->curr_best_solution <= optimal) {
+		emitStatus(j, "[%s] Solution with %d edges is optimal\n", j->label, j->curr_best_solution);
+		closeJob(j);
+	} else if (j->curr_best_solution == 0) {
+		closeJob(j);
+	}
+}
+
+/**
+ * Returns the deadline of a job
+ * @param j The job
+ * @param limits The limits
+ * @return Returns the getMonotonicMillis time the job ends at by -timeout or -stall, 0 if it has no such limit.
 */
-static int readBuff(removedEdge edges_to_read[]) {
-	sem_wait(used_sem);
-	int removed_edges_count = edges_to_read[rd_pos].numOfEdges;
-	sem_post(free_sem);
-	rd_pos += 1;
-	rd_pos %= sizeof(edges_to_read);
-	return removed_edges_count;
+static unsigned long jobDeadline(const job *j, const jobLimits *limits) {
+	unsigned long deadline = 0;
+	if (limits->timeout > 0) {
+		deadline = j->started + limits->timeout;
+	}
+	if (limits->stall > 0 && (deadline == 0 || j->improved + limits->stall < deadline)) {
+		deadline = j->improved + limits->stall;
+	}
+	return deadline;
+}
+
+/**
+ * Checks the limits of a job
+ * @brief Closes the job if it reached the target, the timeout or the stall limit, see jobLimits
+ * @param j The job (open)
+ * @param limits The limits
+*/
+static void checkLimits(job *j, const jobLimits *limits) {
+	unsigned long now = getMonotonicMillis();
+	int reached = j->curr_best_solution <= limits->target;
+	int timeout = limits->timeout > 0 && now >= j->started + limits->timeout;
+	int stalled = limits->stall > 0 && now >= j->improved + limits->stall;
+	if (!reached && !timeout && !stalled) {
+		return;
+	}
+	if (reached) {
+		emitStatus(j, "[%s] Target of %d edges reached after %.3f s\n", j->label, limits->target, (now - j->started) / 1e3);
+	} else if (timeout) {
+		emitStatus(j, "[%s] Timeout after %.3f s\n", j->label, (now - j->started) / 1e3);
+	} else {
+		emitStatus(j, "[%s] No improvement for %.3f s\n", j->label, (now - j->improved) / 1e3);
+	}
+	closeJob(j);
+}
+
+/**
+ * Writes the improvement traces
+ * @brief Writes one CSV line (job, seconds since the job was opened, edges, generator pid) per improvement of every job
+ * @details Errors are reported but not fatal
+ * @param jobs The jobs
+ * @param num_jobs The number of jobs
+ * @param path The file, "-" for stdout
+*/
+static void writeTrace(const job jobs[], int num_jobs, const char *path) {
+	FILE *out = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+	if (out == NULL) {
+		fprintf(stderr, "[%s] Couldn't write %s\n", pgm_name, path);
+		return;
+	}
+	fprintf(out, "job,seconds,edges,generator\n");
+	for (int i = 0; i < num_jobs; i++) {
+		for (int k = 0; k < jobs[i].num_trace; k++) {
+			const improvement *imp = &jobs[i].trace[k];
+			fprintf(out, "%s,%.3f,%d,%d\n", jobs[i].id != NULL ? jobs[i].id : "default", imp->time / 1e3, imp->edges,
+				imp->generator);
+		}
+	}
+	if (out != stdout && fclose(out) != 0) {
+		fprintf(stderr, "[%s] Couldn't write %s\n", pgm_name, path);
+	}
+}
+
+/**
+ * Usage function
+ * @brief Prints the synopsis of the supervisor to stderr and exits
+ * @details global variables: pgm_name
+*/
+static void usage() {
+	(void) fprintf(stderr, "Usage: %s [-n slots] [-w max_edges] [-wait spin|adaptive|block] [-l port] [-scale max [-cpu percent | -rate improvements] [-g command]] [-stats seconds [-prom file]] [-portfolio seconds] [-timeout seconds] [-stall seconds] [-target edges] [-trace file] [-o file] [-format text|json|binary] [-f file] [-j job [-f file]]...\n", pgm_name);
+	exit(EXIT_FAILURE);
+}
+
+/**
+ * Parse a positive integer argument
+ * @brief Parses optarg as a decimal number in the range [min, max]
+ * @details Calls usage() if the argument is not a number or out of range
+ * @param arg The argument string
+ * @param min The smallest accepted value
+ * @param max The largest accepted value
+ * @return Returns the parsed value.
+*/
+static long parsePositive(const char *arg, long min, long max) {
+	char *end;
+	long value = strtol(arg, &end, 10);
+	if (*arg == '\0' || *end != '\0' || value < min || value > max) {
+		usage();
+	}
+	return value;
 }
 
 /**
  * Program entry point.
  * @brief The program starts here. The supervisor creates and manages the semaphores and shared memory object. 
  * @details If any creation, opening or closing fails, the program will immediately exit. 
- * The supervisor reads from the buffer the best solution so far and prints it out as long as a SIGNAL has come.
- * If a SIGINT or SIGTERM signal has come, the supervisor tells the generators to terminate.
+ * -n sets the number of cells of the circular buffer, -w the maximum number of edges per solution.
+ * -j serves a named job (repeatable, up to MAX_JOBS), generators attach with the same -j. Without -j the default job is served.
+ * -f loads a graph into the shared graph segment of the job named by the preceding -j (the first job if none precedes it),
+ * generators of that job started without a graph then work on it.
+ * -wait selects how the supervisor waits for solutions (default adaptive), see waitPolicy.
+ * -l accepts generators on other hosts (started with -c) on the given TCP port, see net.h.
+ * -scale lets the supervisor run up to max local generators of its own (the command given with -g, default
+ * DEFAULT_SPAWN_COMMAND) for the jobs with a shared graph. It forks and stops them to keep the host at -cpu percent
+ * utilization (default DEFAULT_TARGET_CPU), or with -rate every job at about the given improvements per second, see scaler.
+ * The registry entries of generators that died are reaped either way.
+ * -stats prints the counters of the generators and buffers of every job at the given interval, -prom also writes
+ * them to a Prometheus text file (rewritten every interval), see statsReporter.
+ * -portfolio assigns strategies to the registered generators every given number of seconds and moves them towards the
+ * strategies that improve the best solution the most per search second (multi-armed bandit), see portfolio.
+ * -timeout ends every job the given number of seconds after it was opened, -stall once it didn't improve for that many
+ * seconds and -target once its best solution has at most that many edges, see jobLimits. -trace writes the
+ * improvements of all jobs with their time and generator to a CSV file ("-" for stdout) at exit.
+ * -o writes the solutions to a file instead of stdout ("-" for stdout), -format selects their format (default text),
+ * see outputFormat. A writer thread does the output, reading the buffers never waits for it, see outputWriter.
+ * The supervisor reads from the buffers the best solution so far and prints it out as long as a SIGNAL has come.
+ * A job ends once the graph is found 3-colorable or a generator proved its best solution optimal (-s exact). If a SIGINT or SIGTERM signal has come, the supervisor tells the
+ * generators of all jobs to terminate.
  * @param argc The argument counter.
  * @param argv The argument vector.
  * @return Returns EXIT_SUCCESS.
@@ -120,60 +1948,245 @@ static int readBuff(removedEdge edges_to_read[]) {
 int main(int argc, char **argv) {
 	pgm_name = argv[0];
  
-	if(argc != 1) {
-		printErrAndExit("Invalid arguments");
-    }
+	unsigned long capacity = MAX_DATA;
+	int max_edges = MAX_SOLUTION_EDGES;
+	int policy = WAIT_ADAPTIVE;
+	int port = -1;
+	static scaler scale = {.target_cpu = DEFAULT_TARGET_CPU};
+	static char spawn_command[] = DEFAULT_SPAWN_COMMAND;
+	char *command = spawn_command;
+	static statsReporter stats;
+	static portfolio pf;
+	jobLimits limits = {0};
+	const char *trace_path = NULL, *output_path = NULL;
+	static job jobs[MAX_JOBS];
+	int num_jobs = 0;
+	const char *first_graph_path = NULL;
+	static const struct option long_options[] = {
+		{"n", required_argument, NULL, 'n'},
+		{"w", required_argument, NULL, 'w'},
+		{"f", required_argument, NULL, 'f'},
+		{"j", required_argument, NULL, 'j'},
+		{"wait", required_argument, NULL, 'p'},
+		{"l", required_argument, NULL, 'l'},
+		{"scale", required_argument, NULL, 'a'},
+		{"cpu", required_argument, NULL, 'u'},
+		{"rate", required_argument, NULL, 'r'},
+		{"g", required_argument, NULL, 'g'},
+		{"stats", required_argument, NULL, 's'},
+		{"prom", required_argument, NULL, 'e'},
+		{"timeout", required_argument, NULL, 't'},
+		{"stall", required_argument, NULL, 'i'},
+		{"target", required_argument, NULL, 'x'},
+		{"trace", required_argument, NULL, 'o'},
+		{"portfolio", required_argument, NULL, 'y'},
+		{"o", required_argument, NULL, 'O'},
+		{"format", required_argument, NULL, 'F'},
+		{NULL, 0, NULL, 0}
+	};
+	int c;
+	while ((c = getopt_long_only(argc, argv, "n:w:f:j:l:g:", long_options, NULL)) != -1) {
+		switch (c) {
+			case 'n':
+				capacity = parsePositive(optarg, 2, MAX_RING_SLOTS);
+				break;
+			case 'w':
+				max_edges = parsePositive(optarg, 0, MAX_RING_WIDTH);
+				break;
+			case 'f':
+				if (num_jobs == 0) {
+					first_graph_path = optarg;
+				} else {
+					jobs[num_jobs - 1].graph_path = optarg;
+				}
+				break;
+			case 'j':
+				if (num_jobs == MAX_JOBS || initJobNames(&jobs[num_jobs].names, optarg) == -1) {
+					usage();
+				}
+				for (int i = 0; i < num_jobs; i++) {
+					if (strcmp(jobs[i].id, optarg) == 0) {
+						usage();
+					}
+				}
+				jobs[num_jobs++].id = optarg;
+				break;
+			case 'a':
+				scale.max_spawned = parsePositive(optarg, 1, MAX_GENERATORS);
+				break;
+			case 'u':
+				scale.target_cpu = parsePositive(optarg, 1, 100);
+				break;
+			case 'r':
+				scale.target_rate = parsePositive(optarg, 1, INT_MAX);
+				break;
+			case 'g':
+				command = optarg;
+				break;
+			case 's':
+				stats.interval = parsePositive(optarg, 1, INT_MAX);
+				break;
+			case 'e':
+				stats.prom_path = optarg;
+				break;
+			case 't':
+				limits.timeout = parsePositive(optarg, 1, INT_MAX) * 1000UL;
+				break;
+			case 'i':
+				limits.stall = parsePositive(optarg, 1, INT_MAX) * 1000UL;
+				break;
+			case 'x':
+				limits.target = parsePositive(optarg, 0, INT_MAX);
+				break;
+			case 'o':
+				trace_path = optarg;
+				break;
+			case 'y':
+				pf.interval = parsePositive(optarg, 1, INT_MAX);
+				break;
+			case 'O':
+				output_path = optarg;
+				break;
+			case 'F': {
+				int format = parseOutputFormat(optarg);
+				if (format == -1) {
+					usage();
+				}
+				output.format = format;
+				break;
+			}
+			case 'l':
+				port = parsePositive(optarg, 1, 65535);
+				break;
+			case 'p':
+				if ((policy = parseWaitPolicy(optarg)) == -1) {
+					usage();
+				}
+				break;
+			default:
+				usage();
+		}
+	}
+	if (optind != argc || (stats.prom_path != NULL && stats.interval == 0)) {
+		usage();
+	}
+	if (num_jobs == 0) {
+		initJobNames(&jobs[num_jobs++].names, NULL);
+	}
+	if (first_graph_path != NULL) {
+		if (jobs[0].graph_path != NULL) {
+			usage();
+		}
+		jobs[0].graph_path = first_graph_path;
+	}
 
 	initializeSignalHandling();
-    initializeSemaphores();
 
-	int shmfd = createSHMFileDescriptor();
-	myshm *myshm = createMappedSHMObject(shmfd);
+	output.file = stdout;
+	if (output_path != NULL && strcmp(output_path, "-") != 0 && (output.file = fopen(output_path, "w")) == NULL) {
+		printErrAndExit("Opening the output file failed");
+	}
+	for (int i = 0; i < num_jobs; i++) {
+		openJob(&jobs[i], capacity, max_edges);
+	}
+	startWriter(&output, jobs, max_edges);
 
-	/* DONE SETTING UP SHARED MEMORY OBJECT */
+	static listener remote;
+	if (port != -1) {
+		startListener(&remote, port, jobs, num_jobs, max_edges);
+	}
 
-	myshm->generator_count = 0;	
-	int curr_best_solution = INT_MAX;
+	if (scale.max_spawned > 0 && startScaler(&scale, command, jobs, num_jobs) == -1) {
+		usage();
+	}
+	if (stats.interval > 0) {
+		stats.jobs = jobs;
+		stats.num_jobs = num_jobs;
+		startBackgroundThread(&stats.thread, runStats, &stats);
+	}
+	if (pf.interval > 0) {
+		pf.jobs = jobs;
+		pf.num_jobs = num_jobs;
+		startBackgroundThread(&pf.thread, runPortfolio, &pf);
+	}
 
-	while (!quit) {
-		int temp = readBuff(myshm->removed_edges);
-		if (temp == 0) {
-			curr_best_solution = 0;
-			break;
+	/* DONE SETTING UP SHARED MEMORY OBJECTS */
+
+	edge *decoded = NULL;
+	int decoded_capacity = 0;
+	int active = num_jobs;
+	while (!quit && active > 0) {
+		myshm *rings[MAX_JOBS];
+		int num_rings = 0;
+		unsigned long deadline = 0;
+		for (int i = 0; i < num_jobs; i++) {
+			// Closed jobs may still have status lines that didn't fit into the output queue
+			if (jobs[i].done) {
+				flushPending(&jobs[i], 0);
+			}
+			if (hasPendingOutput(&jobs[i])) {
+				deadline = getMonotonicMillis() + OUTPUT_RETRY;
+			}
+		}
+		for (int i = 0; i < num_jobs; i++) {
+			if (!jobs[i].done) {
+				rings[num_rings++] = jobs[i].myshm;
+				unsigned long job_deadline = jobDeadline(&jobs[i], &limits);
+				if (job_deadline != 0 && (deadline == 0 || job_deadline < deadline)) {
+					deadline = job_deadline;
+				}
+			}
+		}
+		if (readBuff(rings, num_rings, policy, deadline) == -1) {
+			continue;
 		}
-		if (temp < curr_best_solution) {
-			printf("[%s] Solution with %d edges:", pgm_name, temp);
-			for (int j = 0; j < temp; j++) {
-				int source = myshm->removed_edges[rd_pos].edges[j].source;
-				int destination = myshm->removed_edges[rd_pos].edges[j].destination;
-				printf(" %d - %d ", source, destination);
+		for (int i = 0; i < num_jobs; i++) {
+			if (!jobs[i].done) {
+				serveJob(&jobs[i], &decoded, &decoded_capacity);
+				if (!jobs[i].done) {
+					checkLimits(&jobs[i], &limits);
+				}
+				active -= jobs[i].done;
 			}
-			printf("\n");
-			curr_best_solution = temp;
 		}
 	}
-
-	sem_wait(mutex_sem);
-	myshm->state = 1;
-	sem_post(mutex_sem);
-	
-	for (int i = 0; i < myshm->generator_count; i++) {
-		sem_post(free_sem);
+	free(decoded);
+	if (port != -1) {
+		stopListener(&remote);
 	}
-	
-	printf("[%s] Best found solution: %d edges\n", pgm_name, curr_best_solution);
-
-	if (curr_best_solution == 0) {
-		printf("[%s] The graph is 3-colorable!\n", pgm_name);
+	if (scale.max_spawned > 0) {
+		stopScaler(&scale);
+	}
+	if (stats.interval > 0) {
+		__atomic_store_n(&stats.stop, 1, __ATOMIC_RELEASE);
+		pthread_join(stats.thread, NULL);
+	}
+	if (pf.interval > 0) {
+		__atomic_store_n(&pf.stop, 1, __ATOMIC_RELEASE);
+		pthread_join(pf.thread, NULL);
 	}
 
-
-    /* CLOSE, UNLINK AND DEALLOCATE  */
-	closeSemaphores(used_sem, free_sem, mutex_sem);
-	unmapSHM(myshm);
-	unlinkRessources();
+	for (int i = 0; i < num_jobs; i++) {
+		if (!jobs[i].done) {
+			closeJob(&jobs[i]);
+		}
+	}
+	// Nothing is read anymore, so the rest of the output may wait for room
+	for (int i = 0; i < num_jobs; i++) {
+		flushPending(&jobs[i], 1);
+	}
+	stopWriter(&output);
+	waitSpawned(&scale);
+	if (trace_path != NULL) {
+		writeTrace(jobs, num_jobs, trace_path);
+	}
+	for (int i = 0; i < num_jobs; i++) {
+		free(jobs[i].trace);
+		free(jobs[i].held);
+		free(jobs[i].status);
+	}
 	
     printf("[%s] Terminating...\n", pgm_name);
 
 	return EXIT_SUCCESS;
-}
\ No newline at end of file
+}